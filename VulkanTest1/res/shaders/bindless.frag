@@ -0,0 +1,20 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 color;
+layout(location = 1) in vec2 texCoords;
+
+layout(location = 0) out vec4 fragColor;
+
+layout(set = 0, binding = 0) uniform sampler2D textures[];
+
+layout(push_constant) uniform Indices
+{
+	uint objectBuffer;
+	uint textureIndex;
+};
+
+void main()
+{
+	fragColor = texture(textures[textureIndex], texCoords) * vec4(color,1);
+}
@@ -0,0 +1,40 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec4 i_Position;
+layout(location = 1) in vec3 i_Color;
+layout(location = 2) in vec2 i_TexCoords;
+
+
+layout(location = 0) out vec3 color;
+layout(location = 1) out vec2 texCoords;
+
+
+struct Object
+{
+	mat4 projMat;
+	mat4 viewMat;
+	mat4 modelMat;
+};
+
+// The bindless heap, the frame's objects are one of its buffers
+layout(set = 0, binding = 1) readonly buffer Objects
+{
+	Object objects[];
+} buffers[];
+
+layout(push_constant) uniform Indices
+{
+	uint objectBuffer;
+	uint textureIndex;
+};
+
+void main()
+{
+	// One instance per draw, firstInstance is the object
+	Object object = buffers[objectBuffer].objects[gl_InstanceIndex];
+
+	gl_Position = object.projMat * object.viewMat * object.modelMat * i_Position;
+	color = i_Color;
+	texCoords = i_TexCoords;
+}
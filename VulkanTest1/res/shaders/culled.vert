@@ -0,0 +1,46 @@
+#version 450
+
+layout(location = 0) in vec4 i_Position;
+layout(location = 1) in vec3 i_Color;
+layout(location = 2) in vec2 i_TexCoords;
+
+
+layout(location = 0) out vec3 color;
+layout(location = 1) out vec2 texCoords;
+
+
+// Once per frame, the objects only differ by their position
+layout(binding = 0) uniform Camera
+{
+	mat4 projMat;
+	mat4 viewMat;
+	float rotation;
+};
+
+// The culled objects, only the center of their bounds is used
+struct Object
+{
+	vec4 sphere;
+	uvec4 draw;
+};
+
+layout(binding = 2) readonly buffer Objects
+{
+	Object objects[];
+};
+
+void main()
+{
+	// Each indirect draw has the object as its first instance
+	vec3 position = objects[gl_InstanceIndex].sphere.xyz;
+	float c = cos(rotation), s = sin(rotation);
+	mat4 modelMat = mat4(
+		vec4(c, 0, -s, 0),
+		vec4(0, 1, 0, 0),
+		vec4(s, 0, c, 0),
+		vec4(position, 1));
+
+	gl_Position = projMat * viewMat * modelMat * i_Position;
+	color = i_Color;
+	texCoords = i_TexCoords;
+}
@@ -0,0 +1,1429 @@
+#pragma once
+
+#include "stb_image.h"
+#include "abstraction/RenderInstance.h"
+#include "VulkanImpl/VulkanRenderInstance.h"
+#include "abstraction/RenderDevice.h"
+#include "VulkanImpl/VulkanRenderDevice.h"
+#include "VulkanImpl/VulkanReceipe.h"
+#include "VulkanImpl/Conversions.h"
+#include "VulkanImpl/VulkanImageView.h"
+#include "VulkanImpl/VulkanBuffer.h"
+#include "VulkanImpl/VulkanImage.h"
+#include "VulkanImpl/VulkanUniformRing.h"
+#include "VulkanImpl/VulkanUploader.h"
+#include "VulkanImpl/VulkanParallelRecorder.h"
+#include "VulkanImpl/VulkanRenderGraph.h"
+#include "VulkanImpl/VulkanGpuProfiler.h"
+#include "VulkanImpl/VulkanShaderProgram.h"
+#include "VulkanImpl/VulkanShaderCompiler.h"
+#include "VulkanImpl/VulkanPipelineManager.h"
+#include "VulkanImpl/VulkanBindlessHeap.h"
+#include "VulkanImpl/VulkanDescriptorAllocator.h"
+#include "VulkanImpl/VulkanInstanceBatcher.h"
+#include "VulkanImpl/VulkanGpuCuller.h"
+#include "ThreadPool.h"
+#include "FrameTimer.h"
+#include "Tracing.h"
+#include "FileWatcher.h"
+#include <filesystem>
+#include <future>
+
+// Timings of one frame in milliseconds, gpuTime is negative when the queue can't write timestamps
+struct FrameStats
+{
+    double frameTime = 0;
+    double recordTime = 0;
+    double submitTime = 0;
+    double gpuTime = -1;
+    // Gpu time of every render graph pass, empty when gpuTime is negative
+    std::vector<GpuScopeTiming> passTimes;
+};
+
+struct AppDesc
+{
+    uint32_t framesInFlight = 2;
+    uint32_t objectCount = 1;
+    uint32_t threadCount = ThreadPool::DefaultThreadCount();
+    // Renders into offscreen images without a window, for benchmarks on machines with no display
+    bool headless = false;
+    // Loads the validation layers, they sit in every recorded and submitted command so measurements turn them off
+    bool validation = true;
+    Dimensions2Du dimensions = { 1280,720 };
+    // 0 runs until the window is closed, a headless run needs a limit
+    uint64_t frameLimit = 0;
+    // 0 loads the texture file, anything else generates a textureSize x textureSize checkerboard
+    uint32_t textureSize = 0;
+    // Keeps the FrameStats of every frame, see GetFrameStats()
+    bool collectStats = false;
+    // Writes a Chrome trace of the frames [traceStart, traceStart + traceFrames) when set
+    std::string tracePath;
+    uint64_t traceStart = 0;
+    uint64_t traceFrames = 300;
+    // Rebuilds the pipeline in the background when a shader source is saved
+    bool hotReload = false;
+    // Texture and objects read through the device's bindless heap, no descriptor binds per draw (needs descriptor indexing)
+    bool bindless = false;
+    // Model matrices pushed with every draw, the uniform ring only holds the frame's camera (ignored with bindless)
+    bool pushConstants = false;
+    // Objects sharing pipeline, material and mesh are drawn with one instanced draw, their models are a per instance stream
+    // (ignored with bindless, takes over pushConstants)
+    bool instancing = false;
+    // Objects are frustum culled by a compute pass and drawn with indirect draws, the cpu work doesn't grow with objectCount
+    // (needs multiDrawIndirect and drawIndirectFirstInstance, ignored with bindless, takes over instancing and pushConstants)
+    bool gpuCulling = false;
+};
+
+class App
+{
+public:
+    static constexpr std::array<const char*, 1> requiredExt{ VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+
+
+    struct QueueFamiliesIndices
+    {
+        std::optional<uint32_t> graphicsFamily;
+        std::optional<uint32_t> presentationFamily;
+
+        operator bool() { return graphicsFamily.has_value() && presentationFamily.has_value(); }
+    };
+    struct SurfaceDetails
+    {
+        vk::SurfaceCapabilitiesKHR capabilities;
+        std::vector<vk::SurfaceFormatKHR> formats;
+        std::vector<vk::PresentModeKHR> presentModes;
+    };
+    struct Vertex
+    {
+        glm::vec2 position;
+        glm::vec3 color;
+        glm::vec2 texCoords;
+    };
+    struct UniformData
+    {
+        alignas(16) glm::mat4 proj;
+        alignas(16) glm::mat4 view;
+        alignas(16) glm::mat4 model;
+    };
+    // Uniform and push constants of push.vert, the model is the only thing that changes between draws
+    struct CameraData
+    {
+        alignas(16) glm::mat4 proj;
+        alignas(16) glm::mat4 view;
+    };
+    struct ObjectConstants
+    {
+        glm::mat4 model;
+    };
+    // Uniform of culled.vert, the objects only move with the rotation shared by all of them
+    struct CulledCameraData
+    {
+        alignas(16) glm::mat4 proj;
+        alignas(16) glm::mat4 view;
+        float rotation;
+    };
+    // Push constants of the bindless shaders
+    struct BindlessIndices
+    {
+        uint32_t objectBuffer;
+        uint32_t textureIndex;
+    };
+    struct FrameData
+    {
+        vk::Fence inFlight;
+        vk::Semaphore imageAvailable;
+
+        vk::CommandPool commandPool;
+        vk::CommandBuffer commandBuffer;
+
+        std::vector<uint32_t> uniformOffsets;
+        // With push constants
+        uint32_t cameraOffset;
+        std::vector<ObjectConstants> objects;
+        // With gpu culling
+        glm::mat4 viewProj;
+
+        // Filled while the frame is recorded, completed with the gpu time once its fence is signaled
+        FrameStats stats;
+        bool statsPending = false;
+        std::chrono::steady_clock::time_point submitTime;
+    };
+    // A shader program and the pipeline compiled from it, the hot reload replaces both together
+    struct ShaderPipeline
+    {
+        VulkanShaderProgram* program = nullptr;
+        PipelineHandle pipeline = VulkanPipelineManager::InvalidHandle;
+    };
+    struct RetiredPipeline
+    {
+        ShaderPipeline shaders;
+        // frameCount when it was replaced
+        uint64_t frame;
+    };
+public:
+    App(const AppDesc& desc = {})
+        :appDesc(desc), objectCount(desc.objectCount), threadPool(desc.threadCount), frames(desc.framesInFlight)
+    {
+        ASSERT(desc.framesInFlight > 0, "At least one frame in flight is needed");
+        ASSERT(desc.objectCount > 0, "At least one object is needed");
+        ASSERT(!desc.headless || desc.frameLimit > 0, "A headless run needs a frame limit");
+    }
+
+    void Run()
+    {
+        init();
+        loop();
+        finish();
+    }
+
+    // Frames in completion order, only filled with AppDesc::collectStats
+    inline const std::vector<FrameStats>& GetFrameStats() const { return frameStats; }
+private:
+    void init()
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        TRACE_THREAD_NAME("Main");
+        if (!appDesc.tracePath.empty())
+            Tracer::Get().Configure(appDesc.tracePath, appDesc.traceStart, appDesc.traceFrames);
+
+        createWindow();
+        initVulkan();
+        // Frames that skip their draws would skew the measured frames
+        if (appDesc.collectStats)
+            pipelineManager->WaitIdle();
+
+        LOG_INFO("Startup took %.2f ms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    void loop()
+    {
+        while (!shouldStop())
+        {
+            Tracer::Get().NextFrame();
+
+            if (window)
+                glfwPollEvents();
+
+            if (framebufferResized || renderDevice->GetSwapchain()->IsOutOfDate())
+            {
+                if (!resizeSwapchain())
+                {
+                    glfwWaitEvents();
+                    continue;
+                }
+            }
+
+            // Only wait for the frame that used these resources framesInFlight frames ago,
+            // the gpu keeps working on the other frames while this one is recorded
+            FrameData& frame = frames[currentFrame];
+            {
+                TRACE_ZONE("Wait for frame");
+                device.waitForFences(frame.inFlight, true, UINT64_MAX);
+            }
+            collectFrameStats(frame);
+            collectRenderFinished(false);
+            updateShaderReload();
+            if (bindlessHeap)
+                bindlessHeap->BeginFrame();
+            descriptorAllocator->BeginFrame(currentFrame);
+
+            // The offscreen images are ordered by the queue alone, semaphores would cost an empty submission to acquire and one to present
+            const bool presentSemaphores = !appDesc.headless;
+            VulkanReceipe imageReady(device, { frame.imageAvailable, false, nullptr, false });
+            SwapchainImage currentImage;
+            {
+                TRACE_ZONE("Acquire");
+                currentImage = renderDevice->GetSwapchain()->GetNextImage(presentSemaphores ? &imageReady : nullptr);
+            }
+            if (!currentImage.image)
+                continue;
+
+            // The graph's framebuffers reference the swapchain views by handle
+            if (swapchainGeneration != renderDevice->GetSwapchain()->GetGeneration())
+            {
+                renderGraph->ResetFramebuffers();
+                createRenderFinished();
+                swapchainGeneration = renderDevice->GetSwapchain()->GetGeneration();
+            }
+            vk::Semaphore renderFinished = renderFinishedSemaphores[currentImage.index];
+            auto recordStart = std::chrono::steady_clock::now();
+            {
+                TRACE_ZONE("Record");
+                updateUniformBuffer(frame, currentFrame);
+                recordCommandBuffer(frame, currentImage.index);
+            }
+            auto submitStart = std::chrono::steady_clock::now();
+
+            //Drawing
+            {
+                TRACE_ZONE("Submit");
+                vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+                auto submitInfo = vk::SubmitInfo().setCommandBufferCount(1).setPCommandBuffers(&frame.commandBuffer);
+                if (presentSemaphores)
+                    submitInfo.setWaitSemaphoreCount(1).setPWaitSemaphores(&frame.imageAvailable)
+                              .setSignalSemaphoreCount(1).setPSignalSemaphores(&renderFinished)
+                              .setPWaitDstStageMask(&waitStage);
+
+                device.resetFences(frame.inFlight);
+                queues.graphicsQueue.submit(submitInfo, frame.inFlight);
+            }
+
+            //Presenting
+            {
+                TRACE_ZONE("Present");
+                VulkanReceipe renderDone(device, { renderFinished, false, nullptr, false });
+                Receipe* receipe = &renderDone;
+                renderDevice->GetSwapchain()->Present(presentSemaphores ? ArrayProxy<Receipe*>(receipe) : nullptr);
+            }
+            auto submitEnd = std::chrono::steady_clock::now();
+
+            currentFrame = (currentFrame + 1) % frames.size();
+            frameCount++;
+            frameTimer.Tick();
+
+            frame.stats.frameTime = frameTimer.GetLastFrameTime();
+            frame.stats.recordTime = std::chrono::duration<double, std::milli>(submitStart - recordStart).count();
+            frame.stats.submitTime = std::chrono::duration<double, std::milli>(submitEnd - submitStart).count();
+            frame.statsPending = true;
+            frame.submitTime = submitStart;
+
+            TRACE_COUNTER("Frame time (ms)", frame.stats.frameTime);
+        }
+
+        device.waitIdle();
+
+        // Oldest frame first, so that the stats stay in submission order
+        for (uint32_t i = 0; i < frames.size(); i++)
+            collectFrameStats(frames[(currentFrame + i) % frames.size()]);
+    }
+    // The frame's fence must be signaled
+    void collectFrameStats(FrameData& frame)
+    {
+        if (!frame.statsPending)
+            return;
+        frame.statsPending = false;
+
+        if (profiler && profiler->Resolve((uint32_t)(&frame - frames.data())))
+        {
+            frame.stats.gpuTime = profiler->GetScopeTime("Frame");
+            frame.stats.passTimes.clear();
+            for (const auto& timing : profiler->GetResults())
+            {
+                if (timing.depth > 0)
+                    frame.stats.passTimes.push_back(timing);
+            }
+            traceGpuScopes(frame);
+        }
+
+        if (appDesc.collectStats)
+            frameStats.push_back(frame.stats);
+    }
+    void traceGpuScopes(const FrameData& frame)
+    {
+        if (!Tracer::Get().IsCapturing())
+            return;
+
+        // Without calibrated timestamps the gpu work is assumed to start when the frame is submitted
+        std::chrono::steady_clock::time_point start = frame.submitTime;
+        profiler->GetFrameStartTime(start);
+
+        auto toDuration = [](double milliseconds)
+        {
+            return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(milliseconds));
+        };
+        for (const auto& timing : profiler->GetResults())
+            Tracer::Get().AddGpuZone(timing.name, start + toDuration(timing.start), start + toDuration(timing.start + timing.milliseconds));
+    }
+    bool shouldStop()
+    {
+        if (appDesc.frameLimit && frameCount >= appDesc.frameLimit)
+            return true;
+        return window && glfwWindowShouldClose(window);
+    }
+    void finish()
+    {
+        // The application may stop in the middle of the trace window
+        Tracer::Get().Flush();
+
+        delete vertexBuffer;
+        delete indexBuffer;
+
+        delete image.view;
+        delete image.handle;
+
+        device.destroySampler(sampler);
+
+        delete uniformRing;
+        delete batcher;
+        delete culler;
+
+        for (auto& frame : frames)
+        {
+            device.destroySemaphore(frame.imageAvailable);
+            device.destroyFence(frame.inFlight);
+
+            device.destroyCommandPool(frame.commandPool);
+        }
+        for (auto semaphore : renderFinishedSemaphores)
+            device.destroySemaphore(semaphore);
+        collectRenderFinished(true);
+        delete recorder;
+        delete profiler;
+
+        delete uploader;
+
+        delete shaderWatcher;
+        // Waits for the compilations still using the programs and destroys every pipeline, retired ones included
+        delete pipelineManager;
+        if (pendingProgram.valid())
+            delete pendingProgram.get();
+        delete reloading.program;
+        for (const auto& retired : retiredPipelines)
+            delete retired.shaders.program;
+        delete shaderProgram;
+
+        delete descriptorAllocator;
+
+        delete renderGraph;
+
+
+        delete renderDevice;;
+        renderInstance->getInstance().destroySurfaceKHR(surface);
+        delete renderInstance;
+
+        if (window)
+        {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
+    }
+private:
+    void createWindow()
+    {
+        window = nullptr;
+        if (appDesc.headless)
+            return;
+
+        ASSERT(glfwInit() == GLFW_TRUE, "Failed to initialize GLFW");
+
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+
+        window = glfwCreateWindow(appDesc.dimensions.width, appDesc.dimensions.height, "Valkan Test", nullptr, nullptr);
+
+        glfwSetWindowUserPointer(window, this);
+        glfwSetFramebufferSizeCallback(window, [](GLFWwindow* window, int width, int height)
+            {
+                static_cast<App*>(glfwGetWindowUserPointer(window))->framebufferResized = true;
+            });
+    }
+    void initVulkan()
+    {
+        createInstance();
+        createLogicalDevice();
+
+        createUploader();
+
+        createSwapChaine();
+
+        createImage();
+        createSampler();
+
+        createRenderPass();
+        createPipeline();
+        if (appDesc.hotReload)
+            shaderWatcher = new FileWatcher(shaderPaths);
+        createUniformBuffers();
+        createDescriptorSets();
+
+        createBuffers();
+
+        createFrames();
+
+        // Everything is recorded by now, the graphics queue orders the first frame after the copies
+        uploader->Submit();
+
+        MemoryStats memoryStats = renderDevice->GetMemoryStats();
+        LOG_INFO("Device memory : %u allocations in %u blocks (%llu/%llu bytes used)", memoryStats.allocationCount, memoryStats.blockCount,
+            (unsigned long long)memoryStats.usedBytes, (unsigned long long)memoryStats.reservedBytes);
+    }
+private:
+    void createInstance()
+    {
+        /*uint32_t count;
+        const char** glfwExt = glfwGetRequiredInstanceExtensions(&count);
+        std::vector<const char*> extensions(glfwExt, glfwExt + count);
+        if (ValidationEnabled) {
+            extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        }
+
+        vk::ApplicationInfo app("Vulkan Test",VK_MAKE_VERSION(1,0,0),
+                                "No Engen",VK_MAKE_VERSION(1,0,0),
+                                VK_API_VERSION_1_1);
+
+        vk::InstanceCreateInfo createInfo;
+        createInfo.pApplicationInfo = &app;
+        createInfo.enabledExtensionCount = extensions.size();
+        createInfo.ppEnabledExtensionNames = extensions.data();
+        
+        vk::DebugUtilsMessengerCreateInfoEXT messagerInfo;
+        if (ValidationEnabled)
+        {
+            using Severity = vk::DebugUtilsMessageSeverityFlagBitsEXT;
+            using Type = vk::DebugUtilsMessageTypeFlagBitsEXT;
+
+            ASSERT(checkValidationSupport(layers), "Validation layer are not supported");
+
+
+            messagerInfo.messageSeverity = Severity::eError | Severity::eWarning | Severity::eInfo | Severity::eVerbose;
+            messagerInfo.messageType = Type::eGeneral | Type::eValidation | Type::ePerformance;
+            messagerInfo.pfnUserCallback = debugCallback;
+
+            createInfo.enabledLayerCount = layers.size();
+            createInfo.ppEnabledLayerNames = layers.data();
+            createInfo.pNext = &messagerInfo;
+        }
+        
+        instance = vk::createInstance(createInfo);
+        LOG_INFO("Instance created successfuly");
+        extFunLoader = vk::DispatchLoaderDynamic(instance,vkGetInstanceProcAddr);
+
+        debugMessager = instance.createDebugUtilsMessengerEXT(messagerInfo,nullptr,extFunLoader);
+        LOG_INFO("Debug mode enabled");*/
+
+        renderInstance = (VulkanRenderInstance*)(RenderInstance::Create(appDesc.validation, appDesc.headless));
+    }
+
+    void createLogicalDevice()
+    {
+        RenderDeviceDesc deviceDesc;
+        deviceDesc.window = window;
+        deviceDesc.framesInFlight = frames.size();
+        deviceDesc.offscreenDimensions = appDesc.dimensions;
+
+        renderDevice = (VulkanRenderDevice*)(renderInstance->CreateDevice(deviceDesc));
+        if (renderDevice->isHeadless())
+            LOG_INFO("Running headless (%ux%u offscreen images)", appDesc.dimensions.width, appDesc.dimensions.height);
+
+        device = renderDevice->getDevice();
+        LOG_INFO("Logical Device created successfuly");
+
+        if (appDesc.bindless)
+        {
+            bindlessHeap = renderDevice->getBindlessHeap();
+            if (!bindlessHeap)
+                LOG_WARN("The device doesn't support descriptor indexing, bindless is disabled");
+        }
+        queues.graphicsQueue = renderDevice->getGraphicsQueue();
+        queues.presentationQueue = renderDevice->getPresentationQueue();
+        
+        surface = renderDevice->getSurface();
+        LOG_INFO("Queues retreived successfuly");
+    }
+    void createSwapChaine()
+    {
+        /*
+        SurfaceDetails details = getSurfaceDetail(renderDevice->getPhysicalDevice());
+        ASSERT(details.formats.size(), "No Format is Suported");
+        ASSERT(details.presentModes.size(), "No present mode is Suported");
+
+        vk::Format format;
+        vk::ColorSpaceKHR colorSpace;
+        {
+            bool found = false;
+            for (auto& surfaceFormat : details.formats)
+            {
+                if (surfaceFormat.format == vk::Format::eR8G8B8A8Srgb && surfaceFormat.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear)
+                {
+                    format = surfaceFormat.format;
+                    colorSpace = surfaceFormat.colorSpace;
+                    found = true;
+                    break;
+                }
+            }
+            if (!found)
+            {
+                format = details.formats[0].format;
+                colorSpace = details.formats[0].colorSpace;
+            }
+        }
+
+        vk::PresentModeKHR presentMode;
+        {
+            bool found = false;
+            for (auto& mode : details.presentModes)
+            {
+                if (mode == vk::PresentModeKHR::eMailbox)
+                {
+                    presentMode = mode;
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) presentMode = vk::PresentModeKHR::eFifo;
+        }
+
+        uint32_t minImageCount;
+        {
+            minImageCount = details.capabilities.minImageCount + 1;
+            if (details.capabilities.maxImageCount != 0)
+                minImageCount = std::min(minImageCount, details.capabilities.maxImageCount);
+        }
+
+        vk::Extent2D extend;
+        {
+            if (details.capabilities.currentExtent == vk::Extent2D(-1, -1))
+            {
+                extend.width = std::clamp(WindowDimonsions.width, details.capabilities.minImageExtent.width, details.capabilities.maxImageExtent.width);
+                extend.height = std::clamp(WindowDimonsions.height, details.capabilities.minImageExtent.height, details.capabilities.maxImageExtent.height);
+            }
+            else
+            {
+                extend = details.capabilities.currentExtent;
+            }
+        }
+
+        vk::SharingMode sharingMode;
+        std::vector<uint32_t> queues;
+        {
+            //std::set<uint32_t> s = { renderDevice->m,renderDevice->m_PresentationFamily };
+            queues.push_back(0);
+            sharingMode = vk::SharingMode::eExclusive;
+        }
+
+        vk::SwapchainCreateInfoKHR swapcahainInfo = { {},
+            surface,
+            minImageCount,
+            format,colorSpace,
+            extend,
+            1,
+            vk::ImageUsageFlagBits::eColorAttachment,
+            sharingMode,(uint32_t)queues.size(),queues.data(),
+            vk::SurfaceTransformFlagBitsKHR::eIdentity,
+            vk::CompositeAlphaFlagBitsKHR::eOpaque,
+            presentMode
+        };
+
+        swapchain.handle = device.createSwapchainKHR(swapcahainInfo);
+        swapchain.format = format;
+        swapchain.colorSpace = colorSpace;
+        swapchain.extent = extend;
+        swapchain.images = device.getSwapchainImagesKHR(swapchain.handle);
+        swapchain.views.resize(swapchain.images.size());
+        for (uint32_t i = 0; i < swapchain.views.size(); i++)
+        {
+            swapchain.views[i] = createImageView(swapchain.images[i],vk::ImageViewType::e2D,swapchain.format);
+        }
+        LOG_INFO("Swapchain created successfuly");
+        */
+    }
+    void createImage()
+    {
+        uint32_t width = 1, height = 1;
+        void* imageData;
+        std::vector<uint32_t> generatedData;
+        //Image Loading
+        if (appDesc.textureSize)
+        {
+            // 8x8 checkerboard, lets benchmarks pick the texture size
+            width = height = appDesc.textureSize;
+            const uint32_t tileSize = std::max(1u, appDesc.textureSize / 8);
+
+            generatedData.resize(width * height);
+            for (uint32_t y = 0; y < height; y++)
+                for (uint32_t x = 0; x < width; x++)
+                    generatedData[y * width + x] = ((x / tileSize + y / tileSize) & 1) ? 0xFFFFFFFF : 0xFF404040;
+            imageData = generatedData.data();
+        }
+        else
+        {
+            int channels,w,h;
+            stbi_set_flip_vertically_on_load(true);
+            imageData = stbi_load("res/textures/SunSet.jpg", &w, &h, &channels, 4);
+            ASSERT(imageData, "Failed to load Image");
+            width = w, height = h;
+        }
+
+        //Image Creation
+        {
+            // The whole mip chain is generated on the gpu when the format allows it
+            const VulkanMipGenerator* mipGenerator = uploader->GetMipGenerator();
+            const vk::Format format = GetVkFormat(image.format);
+            bool generateMips = mipGenerator->GetMethod(format) != VulkanMipGenerator::Method::None;
+            if (!generateMips)
+                LOG_WARN("Mips cannot be generated for %s, the texture keeps a single level", vk::to_string(format).c_str());
+
+            ImageDesc desc; {
+                desc.dimensions = { width,height,1 };
+                desc.type = ImageType::e2D;
+                desc.format = image.format;
+                desc.layers = 1;
+                desc.mipLevels = generateMips ? VulkanMipGenerator::GetMipLevelCount(width, height) : 1;
+                desc.usage = ImageUsageBits::TransferDst | ImageUsageBits::Sampled | GetImageUsage(mipGenerator->GetRequiredUsage(format));
+                desc.gpuAccessRate = ResourceAccessRate::Frequent;
+                desc.cpuAccessibility = ResourceAccessibilityBits::None;
+            }
+            image.handle = renderDevice->CreateImage(desc);
+            image.width = width;
+            image.height = height;
+            image.mipLevels = desc.mipLevels;
+        }
+
+        //Uploading data
+        {
+            VulkanImageUpload upload; {
+                upload.image = static_cast<VulkanImage*>(image.handle)->getVkImage();
+                upload.format = static_cast<VulkanImage*>(image.handle)->getVkFormat();
+                upload.extent = vk::Extent3D(image.width, image.height, 1);
+                upload.mipLevels = image.mipLevels;
+                upload.finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+                upload.dstStages = vk::PipelineStageFlagBits::eFragmentShader;
+                upload.dstAccess = vk::AccessFlagBits::eShaderRead;
+            }
+            uploader->UploadImage(upload, imageData, image.width * image.height * 4);
+            if (!appDesc.textureSize)
+                stbi_image_free(imageData);
+        }
+
+        //View Creation
+        {
+            ImageViewDesc desc; {
+                desc.image = image.handle;
+                desc.dimensions = image.handle->GetDesc().dimensions;
+                desc.type = ImageViewType::e2D;
+                desc.aspect = ImageViewAspect::Color;
+                desc.baseLayer = 0;
+                desc.layers = 1;
+                desc.baseMipLevel = 0;
+                desc.mipLevels = image.mipLevels;
+            }
+            image.view = renderDevice->CreateImageView(desc);
+        }
+    }
+    void createSampler()
+    {
+        auto samplerInfo = vk::SamplerCreateInfo()
+            .setAddressModeU(vk::SamplerAddressMode::eRepeat).setAddressModeV(vk::SamplerAddressMode::eRepeat).setAddressModeW(vk::SamplerAddressMode::eRepeat)
+            .setCompareEnable(false)
+            .setAnisotropyEnable(true)
+            .setMaxAnisotropy(16)
+            .setMagFilter(vk::Filter::eLinear).setMinFilter(vk::Filter::eLinear)
+            .setMinLod(0).setMaxLod((float)image.mipLevels)
+            .setMipmapMode(vk::SamplerMipmapMode::eLinear)
+            .setUnnormalizedCoordinates(false);
+
+        sampler = device.createSampler(samplerInfo);
+    }
+    void createUploader()
+    {
+        uploader = new VulkanUploader(renderDevice);
+    }
+    void createRenderPass()
+    {
+        // Barriers and layout transitions are worked out by the graph every frame,
+        // this render pass is only there to create the pipeline against
+        renderGraph = new VulkanRenderGraph(renderDevice, frames.size());
+        renderPass = renderGraph->GetCompatibleRenderPass({ renderDevice->GetSwapchain()->GetImagesDesc().format }, ImageFormat::Depth32, false);
+        swapchainGeneration = renderDevice->GetSwapchain()->GetGeneration();
+
+        LOG_INFO("RenderPass created successfuly");
+    }
+    bool resizeSwapchain()
+    {
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+        if (width == 0 || height == 0)
+            return false;
+
+        renderDevice->GetSwapchain()->ReSize({ (uint32_t)width,(uint32_t)height });
+        framebufferResized = false;
+
+        return !renderDevice->GetSwapchain()->IsOutOfDate();
+    }
+    // GLSL is compiled on the worker threads and cached under shadercache/, the offline SPIR-V is the fallback
+    std::vector<std::vector<uint32_t>> compileShaders(const std::vector<std::string>& paths)
+    {
+        TRACE_ZONE("Compile shaders");
+
+        std::vector<ShaderCompileDesc> descs;
+        for (const auto& path : paths)
+            descs.push_back({ path, {}, true, false });
+
+        VulkanShaderCompiler compiler("shadercache", &threadPool);
+        std::vector<std::vector<uint32_t>> stages = compiler.CompileAll(descs);
+
+        for (size_t i = 0; i < stages.size(); i++)
+        {
+            if (stages[i].empty())
+            {
+                const std::string fallback = "res/shaders/spir-v/" + std::filesystem::path(paths[i]).filename().string() + ".spv";
+                LOG_WARN("Using the precompiled \"%s\"", fallback.c_str());
+                stages[i] = VulkanShaderProgram::LoadSpirv(fallback);
+            }
+        }
+        LOG_INFO("Shaders : %u/%u from the cache", compiler.GetCacheHits(), (uint32_t)paths.size());
+
+        return stages;
+    }
+
+    // Layouts and vertex input are reflected from the shaders, the uniform ring is bound with dynamic offsets
+    // (or set 0 is the bindless heap) and the vertices only carry a 2D position for the shader's vec4
+    VulkanShaderProgram* createShaderProgram(std::vector<std::vector<uint32_t>> stages)
+    {
+        VulkanShaderProgramDesc programDesc;
+        programDesc.stages = std::move(stages);
+        if (bindlessHeap)
+            programDesc.externalSets[0] = bindlessHeap->getSetLayout();
+        else
+            programDesc.dynamicBuffers = { {0,0} };
+        programDesc.vertexFormats[0] = vk::Format::eR32G32Sfloat;
+        // The model matrix
+        if (batcher)
+            programDesc.firstInstanceLocation = 3;
+
+        return new VulkanShaderProgram(renderDevice, programDesc);
+    }
+    void createPipeline()
+    {
+        if (appDesc.gpuCulling && !bindlessHeap)
+        {
+            gpuCulling = VulkanGpuCuller::IsSupported(renderDevice);
+            if (!gpuCulling)
+                LOG_WARN("The device can't draw indirect with a first instance, gpu culling is disabled");
+        }
+        if (appDesc.instancing && !bindlessHeap && !gpuCulling)
+            batcher = new VulkanInstanceBatcher(sizeof(glm::mat4));
+        pushConstants = appDesc.pushConstants && !bindlessHeap && !batcher && !gpuCulling;
+        if (bindlessHeap)
+            shaderPaths = { "res/shaders/bindless.vert", "res/shaders/bindless.frag" };
+        else if (gpuCulling)
+            shaderPaths = { "res/shaders/culled.vert", "res/shaders/shader.frag" };
+        else if (batcher)
+            shaderPaths = { "res/shaders/instanced.vert", "res/shaders/shader.frag" };
+        else if (pushConstants)
+            shaderPaths = { "res/shaders/push.vert", "res/shaders/shader.frag" };
+        else
+            shaderPaths = { "res/shaders/shader.vert", "res/shaders/shader.frag" };
+
+        shaderProgram = createShaderProgram(compileShaders(shaderPaths));
+        ASSERT(shaderProgram->getVertexStride() == sizeof(Vertex), "The vertex layout doesn't match the shader inputs");
+        ASSERT(!batcher || shaderProgram->getInstanceStride() == batcher->getInstanceStride(), "The instance layout doesn't match the shader inputs");
+
+        pipelineLayout = shaderProgram->getPipelineLayout();
+
+        // Compiles while the rest of the initialization goes on, the first frames skip the draws until it is ready
+        pipelineManager = new VulkanPipelineManager(renderDevice, &pipelineThreadPool);
+        pipeline = pipelineManager->Create(getPipelineDesc(shaderProgram));
+    }
+    VulkanGraphicsPipelineDesc getPipelineDesc(const VulkanShaderProgram* program)
+    {
+        VulkanGraphicsPipelineDesc desc;
+        desc.name = "Main";
+        desc.program = program;
+        desc.renderPass = renderPass;
+        desc.frontFace = vk::FrontFace::eClockwise;
+        desc.cullMode = vk::CullModeFlagBits::eNone;
+
+        return desc;
+    }
+    /*
+        Hot reload, called once per frame after the frame's fence.
+        Saving a shader compiles it on its own thread and queues the new pipeline on the manager, the loop never waits for either :
+        the new pipeline is swapped in at the first frame boundary after it is ready and the old one is destroyed once the frames using it are done.
+    */
+    void updateShaderReload()
+    {
+        // The frames recorded before the swap are done once as many frames as there are in flight started since
+        while (!retiredPipelines.empty() && frameCount - retiredPipelines.front().frame >= frames.size())
+        {
+            pipelineManager->Destroy(retiredPipelines.front().shaders.pipeline);
+            delete retiredPipelines.front().shaders.program;
+            retiredPipelines.erase(retiredPipelines.begin());
+        }
+
+        if (pendingProgram.valid())
+        {
+            if (pendingProgram.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return;
+
+            if (VulkanShaderProgram* program = pendingProgram.get())
+                reloading = { program, pipelineManager->Create(getPipelineDesc(program)) };
+        }
+
+        if (reloading.program)
+        {
+            const PipelineStatus status = pipelineManager->GetStatus(reloading.pipeline);
+            if (status == PipelineStatus::Pending)
+                return;
+
+            if (status == PipelineStatus::Ready)
+            {
+                retiredPipelines.push_back({ { shaderProgram, pipeline }, frameCount });
+                shaderProgram = reloading.program;
+                pipeline = reloading.pipeline;
+                LOG_INFO("Shaders reloaded");
+            }
+            else
+            {
+                LOG_WARN("Keeping the current shaders");
+                delete reloading.program;
+            }
+            reloading = {};
+        }
+
+        std::vector<std::string> changed;
+        if (shaderWatcher && shaderWatcher->PollChanges(changed))
+        {
+            for (const auto& path : changed)
+                LOG_INFO("\"%s\" changed, rebuilding the pipeline", path.c_str());
+            pendingProgram = std::async(std::launch::async, [this]() { return reloadShaderProgram(); });
+        }
+    }
+    // Null when the shaders don't compile or no longer fit the descriptor sets and vertex buffer
+    VulkanShaderProgram* reloadShaderProgram()
+    {
+        TRACE_ZONE("Reload shaders");
+
+        // Not on the pool, ThreadPool::Wait() would also wait for the recording jobs of the frames
+        VulkanShaderCompiler compiler("shadercache");
+        std::vector<std::vector<uint32_t>> stages;
+        for (const auto& path : shaderPaths)
+        {
+            stages.push_back(compiler.Compile({ path, {}, true, false }));
+            if (stages.back().empty())
+            {
+                LOG_WARN("Keeping the current shaders");
+                return nullptr;
+            }
+        }
+
+        VulkanShaderProgram* program = createShaderProgram(std::move(stages));
+        // Layouts are cached, the same interface gives the same handle
+        if (program->getPipelineLayout() != pipelineLayout || program->getVertexStride() != sizeof(Vertex) ||
+            program->getInstanceStride() != shaderProgram->getInstanceStride())
+        {
+            LOG_WARN("The shader interface changed, restart to use the new shaders");
+            delete program;
+            return nullptr;
+        }
+        return program;
+    }
+    void createBuffers()
+    {
+        BufferDesc desc; {
+            desc.usage = BufferUsageBits::VertexBuffer | BufferUsageBits::TransferDst;
+            desc.size = sizeof(verteces);
+            desc.gpuAccessRate = ResourceAccessRate::Frequent;
+            desc.cpuAccessibility = ResourceAccessibilityBits::None;
+        }
+        vertexBuffer = renderDevice->CreateBuffer(desc);
+
+       {
+            desc.usage = BufferUsageBits::IndexBuffer | BufferUsageBits::TransferDst;
+            desc.size = sizeof(indeces);
+            desc.gpuAccessRate = ResourceAccessRate::Frequent;
+            desc.cpuAccessibility = ResourceAccessibilityBits::None;
+       }
+        indexBuffer = renderDevice->CreateBuffer(desc);
+
+        uploader->UploadBuffer(static_cast<VulkanBuffer*>(vertexBuffer), verteces.data(), sizeof(verteces), 0,
+            vk::PipelineStageFlagBits::eVertexInput, vk::AccessFlagBits::eVertexAttributeRead);
+        uploader->UploadBuffer(static_cast<VulkanBuffer*>(indexBuffer), indeces.data(), sizeof(indeces), 0,
+            vk::PipelineStageFlagBits::eVertexInput, vk::AccessFlagBits::eIndexRead);
+    }
+    void createUniformBuffers()
+    {
+        vk::DeviceSize alignment = VulkanUniformRing::GetAlignment(renderDevice);
+
+        const vk::DeviceSize cameraSize = (sizeof(CameraData) + alignment - 1) / alignment * alignment;
+
+        // The models are pushed with the draws, a frame only writes its camera
+        if (pushConstants)
+        {
+            uniformRing = new VulkanUniformRing(renderDevice, cameraSize, frames.size());
+            for (auto& frame : frames)
+                frame.objects.resize(objectCount);
+            return;
+        }
+        // The camera then the instances, all the objects share a batch
+        if (batcher)
+        {
+            uniformRing = new VulkanUniformRing(renderDevice, cameraSize + objectCount * sizeof(glm::mat4), frames.size());
+            return;
+        }
+        // The objects are on the gpu already
+        if (gpuCulling)
+        {
+            uniformRing = new VulkanUniformRing(renderDevice, sizeof(CulledCameraData), frames.size());
+            return;
+        }
+
+        // Every object gets its own slice of the frame's region, so a frame needs objectCount aligned UniformData
+        vk::DeviceSize sliceSize = (sizeof(UniformData) + alignment - 1) / alignment * alignment;
+
+        uniformRing = new VulkanUniformRing(renderDevice, sliceSize * objectCount, frames.size());
+
+        for (auto& frame : frames)
+            frame.uniformOffsets.resize(objectCount);
+    }
+    void createDescriptorSets()
+    {
+        descriptorAllocator = new VulkanDescriptorAllocator(device, frames.size());
+
+        // Indices are stable, they are given once to the shaders through push constants
+        if (bindlessHeap)
+        {
+            textureIndex = bindlessHeap->AddTexture(static_cast<VulkanImageView*>(image.view)->getVkView(), sampler);
+            for (uint32_t i = 0; i < frames.size(); i++)
+                objectBuffers.push_back(bindlessHeap->AddStorageBuffer(uniformRing->getVkBuffer(), uniformRing->getFrameOffset(i), uniformRing->getFrameSize()));
+            return;
+        }
+
+        // A single set for every frame and object : the uniform binding is dynamic, the slice is picked with the offset given at bind time.
+        // Cached, a reloaded program with the same interface gets this same set back
+        if (gpuCulling)
+        {
+            createCuller();
+            descriptorSet = descriptorAllocator->GetCachedSet(shaderProgram->getSetLayouts()[0], {
+                VulkanDescriptorWrite::Buffer(0, vk::DescriptorType::eUniformBufferDynamic, uniformRing->getVkBuffer(), 0, sizeof(CulledCameraData)),
+                VulkanDescriptorWrite::Image(1, vk::DescriptorType::eCombinedImageSampler, static_cast<VulkanImageView*>(image.view)->getVkView(), sampler),
+                VulkanDescriptorWrite::Buffer(2, vk::DescriptorType::eStorageBuffer, culler->getObjectBuffer(), 0, VK_WHOLE_SIZE),
+            });
+            return;
+        }
+
+        descriptorSet = descriptorAllocator->GetCachedSet(shaderProgram->getSetLayouts()[0], {
+            VulkanDescriptorWrite::Buffer(0, vk::DescriptorType::eUniformBufferDynamic, uniformRing->getVkBuffer(), 0, pushConstants || batcher ? sizeof(CameraData) : sizeof(UniformData)),
+            VulkanDescriptorWrite::Image(1, vk::DescriptorType::eCombinedImageSampler, static_cast<VulkanImageView*>(image.view)->getVkView(), sampler),
+        });
+    }
+    void createCuller()
+    {
+        VulkanGpuCullerDesc desc;
+        desc.shader = compileShaders({ "res/shaders/cull.comp" })[0];
+        desc.maxObjects = std::max(objectCount, 1u);
+        desc.framesInFlight = frames.size();
+        culler = new VulkanGpuCuller(renderDevice, descriptorAllocator, desc);
+
+        // Uploaded once, the bounds are the quad's half diagonal whatever its rotation
+        std::vector<GpuCullObject> objects(objectCount);
+        for (uint32_t i = 0; i < objectCount; i++)
+            objects[i] = { glm::vec4(getObjectPosition(i), std::sqrt(0.5f)), (uint32_t)indeces.size(), 0, 0 };
+        culler->SetObjects(uploader, objects);
+    }
+    // For the current swapchain images, the previous set goes once the swapchain is done with its images too
+    void createRenderFinished()
+    {
+        if (renderFinishedSemaphores.size())
+        {
+            const uint64_t delay = std::max<uint64_t>(frames.size(), renderFinishedSemaphores.size());
+            retiredRenderFinished.push_back({ frameCount + delay, std::move(renderFinishedSemaphores) });
+            renderFinishedSemaphores.clear();
+        }
+
+        for (uint32_t i = 0; i < renderDevice->GetSwapchain()->GetImageCount(); i++)
+            renderFinishedSemaphores.push_back(device.createSemaphore({}));
+    }
+    void collectRenderFinished(bool all)
+    {
+        auto it = std::remove_if(retiredRenderFinished.begin(), retiredRenderFinished.end(), [&](const auto& retired)
+            {
+                if (!all && retired.first > frameCount)
+                    return false;
+                for (auto semaphore : retired.second)
+                    device.destroySemaphore(semaphore);
+                return true;
+            });
+        retiredRenderFinished.erase(it, retiredRenderFinished.end());
+    }
+    void createFrames()
+    {
+        auto poolInfo = vk::CommandPoolCreateInfo().setQueueFamilyIndex(renderDevice->getGraphicsFamily())
+            .setFlags(vk::CommandPoolCreateFlagBits::eTransient);
+
+        for (auto& frame : frames)
+        {
+            frame.commandPool = device.createCommandPool(poolInfo);
+            frame.commandBuffer = device.allocateCommandBuffers(vk::CommandBufferAllocateInfo()
+                .setCommandPool(frame.commandPool)
+                .setCommandBufferCount(1)
+                .setLevel(vk::CommandBufferLevel::ePrimary)
+            )[0];
+
+            frame.imageAvailable = device.createSemaphore({});
+            frame.inFlight = device.createFence({ vk::FenceCreateFlagBits::eSignaled });
+        }
+        createRenderFinished();
+
+        recorder = new VulkanParallelRecorder(device, renderDevice->getGraphicsFamily(), frames.size(), &threadPool);
+
+        // The whole frame and each of its passes are timed on the gpu, only when stats or a trace are collected
+        if (appDesc.collectStats || !appDesc.tracePath.empty())
+            profiler = new VulkanGpuProfiler(renderDevice, frames.size());
+        LOG_INFO("Recording draws on %u threads", recorder->GetThreadCount());
+    }
+    void recordCommandBuffer(FrameData& frame, uint32_t imageIndex)
+    {
+        device.resetCommandPool(frame.commandPool, {});
+
+        const Dimensions3Du& dimensions = renderDevice->GetSwapchain()->GetImagesDesc().dimensions;
+
+        vk::Viewport viewport = { 0,0,(float)dimensions.width,(float)dimensions.height,0,1 };
+        vk::Rect2D scissors = { {0,0},{dimensions.width,dimensions.height} };
+
+        renderGraph->BeginFrame(frameCount);
+
+        // The acquire semaphore is waited on at the color output stage, the layout transition has to wait for it too
+        RenderGraphImportedImage backbufferInfo;
+        backbufferInfo.view = renderDevice->GetSwapchain()->GetImageView(imageIndex);
+        backbufferInfo.initialStages = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+        // Offscreen images are never presented, they are left ready to be copied out
+        backbufferInfo.finalLayout = renderDevice->isHeadless() ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR;
+        RenderGraphResource backbuffer = renderGraph->ImportImage("Backbuffer", backbufferInfo);
+
+        // Uploaded and handed over by the uploader already in its shader read layout
+        RenderGraphImportedImage textureInfo;
+        textureInfo.view = image.view;
+        textureInfo.initialLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+        RenderGraphResource texture = renderGraph->ImportImage("Texture", textureInfo);
+
+        RenderGraphResource draws;
+        if (culler)
+            draws = culler->AddPasses(renderGraph, currentFrame, frame.viewProj);
+
+        const vk::Pipeline mainPipeline = pipelineManager->Get(pipeline);
+        renderGraph->AddPass("Main", [&](VulkanRenderGraph::PassBuilder& builder)
+            {
+                builder.Write(backbuffer, RenderGraphUsage::ColorAttachment, vk::ClearValue().setColor(std::array<float, 4>{0.2,0.3,0.8,1}));
+                builder.Read(texture, RenderGraphUsage::SampledFragment);
+                if (culler)
+                    builder.Read(draws, RenderGraphUsage::IndirectBuffer);
+                builder.UseSecondaryCommandBuffers();
+            },
+            [&](const RenderGraphPassContext& context)
+            {
+                // Still compiling or nothing to draw, the pass only clears
+                // The culled draws are a single indirect call
+                const uint32_t drawCount = culler ? 1 : batcher ? (uint32_t)batcher->getBatches().size() : objectCount;
+                if (!mainPipeline || !drawCount)
+                    return;
+
+                // The draws are split in chunks recorded into secondary buffers by the workers,
+                // a couple of chunks per thread keeps them busy when the chunks are uneven
+                const uint32_t chunkCount = std::min(drawCount, recorder->GetThreadCount() * 2);
+                const uint32_t chunkSize = (drawCount + chunkCount - 1) / chunkCount;
+
+                auto inheritance = vk::CommandBufferInheritanceInfo()
+                    .setRenderPass(context.renderPass)
+                    .setSubpass(0)
+                    .setFramebuffer(context.framebuffer);
+
+                recorder->BeginFrame(currentFrame);
+                std::vector<vk::CommandBuffer> secondaries = recorder->Record(chunkCount, inheritance, [&](vk::CommandBuffer commandBuffer, uint32_t chunk)
+                    {
+                        commandBuffer.setViewport(0, viewport);
+                        commandBuffer.setScissor(0, scissors);
+
+                        const uint32_t end = std::min(drawCount, (chunk + 1) * chunkSize);
+                        if (culler)
+                        {
+                            commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, mainPipeline);
+                            commandBuffer.bindVertexBuffers(0, static_cast<VulkanBuffer*>(vertexBuffer)->getVkBuffer(), (vk::DeviceSize)0);
+                            commandBuffer.bindIndexBuffer(static_cast<VulkanBuffer*>(indexBuffer)->getVkBuffer(), 0, vk::IndexType::eUint32);
+                            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, descriptorSet, frame.cameraOffset);
+                            culler->Draw(commandBuffer, currentFrame);
+                            return;
+                        }
+                        // A chunk is a range of batches, they bind their own pipeline and buffers
+                        if (batcher)
+                        {
+                            batcher->Record(commandBuffer, chunk * chunkSize, end - chunk * chunkSize, { frame.cameraOffset });
+                            return;
+                        }
+
+                        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, mainPipeline);
+
+                        commandBuffer.bindVertexBuffers(0, static_cast<VulkanBuffer*>(vertexBuffer)->getVkBuffer(), (vk::DeviceSize)0);
+                        commandBuffer.bindIndexBuffer(static_cast<VulkanBuffer*>(indexBuffer)->getVkBuffer(), 0, vk::IndexType::eUint32);
+                        if (bindlessHeap)
+                        {
+                            // Bound once per buffer, the instance index picks the object
+                            bindlessHeap->Bind(commandBuffer, vk::PipelineBindPoint::eGraphics, pipelineLayout);
+                            const BindlessIndices indices = { objectBuffers[currentFrame], textureIndex };
+                            commandBuffer.pushConstants(pipelineLayout, shaderProgram->getPushConstantRanges()[0].stageFlags, 0, sizeof(indices), &indices);
+
+                            for (uint32_t i = chunk * chunkSize; i < end; i++)
+                                commandBuffer.drawIndexed(indeces.size(), 1, 0, 0, i);
+                            return;
+                        }
+
+                        if (pushConstants)
+                        {
+                            // The camera is bound once per buffer, a draw only costs its push
+                            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, descriptorSet, frame.cameraOffset);
+                            const vk::ShaderStageFlags stages = shaderProgram->getPushConstantRanges()[0].stageFlags;
+                            for (uint32_t i = chunk * chunkSize; i < end; i++)
+                            {
+                                commandBuffer.pushConstants(pipelineLayout, stages, 0, sizeof(ObjectConstants), &frame.objects[i]);
+                                commandBuffer.drawIndexed(indeces.size(), 1, 0, 0, 0);
+                            }
+                            return;
+                        }
+
+                        for (uint32_t i = chunk * chunkSize; i < end; i++)
+                        {
+                            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, descriptorSet, frame.uniformOffsets[i]);
+                            commandBuffer.drawIndexed(indeces.size(), 1, 0, 0, 0);
+                        }
+                    });
+
+                context.commandBuffer.executeCommands(secondaries);
+            });
+
+        renderGraph->Compile();
+
+        vk::CommandBuffer commandBuffer = frame.commandBuffer;
+        commandBuffer.begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+        if (profiler)
+            profiler->BeginFrame(currentFrame, commandBuffer);
+        {
+            VulkanGpuProfiler::Scope frameScope(profiler, commandBuffer, "Frame");
+            renderGraph->Execute(commandBuffer, profiler);
+        }
+        commandBuffer.end();
+    }
+
+    void updateUniformBuffer(FrameData& frame, uint32_t frameIndex)
+    {
+        currentRotation += 0.016f * glm::radians(90.f);
+        UniformData data;
+
+        const Dimensions3Du& dimensions = renderDevice->GetSwapchain()->GetImagesDesc().dimensions;
+
+        data.proj = glm::perspective(glm::radians(70.f), dimensions.width / (float)dimensions.height, 0.1f, 1000.f);
+        data.view = glm::lookAt(glm::vec3{ 0,0,0 }, glm::vec3{ 0,0,-1 }, glm::vec3{ 0,1,0 });
+
+        uniformRing->BeginFrame(frameIndex);
+        // Nothing per object, the culling and the vertex shader find the objects on the gpu
+        if (culler)
+        {
+            frame.cameraOffset = uniformRing->Push(CulledCameraData{ data.proj, data.view, currentRotation });
+            frame.viewProj = data.proj * data.view;
+            uniformRing->EndFrame();
+            return;
+        }
+        if (pushConstants || batcher)
+            frame.cameraOffset = uniformRing->Push(CameraData{ data.proj, data.view });
+        // Every object shares the pipeline, the texture and the quad : a single batch
+        DrawBatchKey batchKey;
+        if (batcher)
+        {
+            batchKey.pipeline = pipelineManager->Get(pipeline);
+            batchKey.layout = pipelineLayout;
+            batchKey.material = descriptorSet;
+            batchKey.mesh = { static_cast<VulkanBuffer*>(vertexBuffer)->getVkBuffer(), static_cast<VulkanBuffer*>(indexBuffer)->getVkBuffer(), (uint32_t)indeces.size() };
+            batcher->Begin();
+        }
+        // The bindless shaders index the objects in the frame's region, they are packed at its start
+        UniformData* objects = nullptr;
+        if (bindlessHeap)
+        {
+            UniformSlice slice = uniformRing->Allocate(sizeof(UniformData) * objectCount);
+            ASSERT(slice.offset == uniformRing->getFrameOffset(frameIndex), "The objects must start the frame's region");
+            objects = (UniformData*)slice.data;
+        }
+        for (uint32_t i = 0; i < objectCount; i++)
+        {
+            data.model = glm::translate(glm::mat4(1), getObjectPosition(i)) * glm::rotate(glm::mat4(1), currentRotation, {0,1,0}) *
+                glm::scale(glm::mat4(1), {1,1,1});
+
+            if (batcher)
+                batcher->Add(batchKey, &data.model);
+            else if (pushConstants)
+                frame.objects[i].model = data.model;
+            else if (objects)
+                objects[i] = data;
+            else
+                frame.uniformOffsets[i] = uniformRing->Push(data);
+        }
+        if (batcher)
+            batcher->End(uniformRing);
+        uniformRing->EndFrame();
+    }
+    // Objects are laid out on a square grid that the camera backs away from to keep it in view
+    glm::vec3 getObjectPosition(uint32_t i) const
+    {
+        const uint32_t columns = (uint32_t)std::ceil(std::sqrt((float)objectCount));
+        const float spacing = 1.2f;
+
+        return {
+            ((i % columns) - (columns - 1) * 0.5f) * spacing,
+            ((i / columns) - (columns - 1) * 0.5f) * spacing,
+            -2.f * columns
+        };
+    }
+
+    template<size_t N>
+    inline  bool checkValidationSupport(const std::array<const char*, N>& layers)
+    {
+        auto props = vk::enumerateInstanceLayerProperties();
+
+        for (auto& layer : layers)
+        {
+            bool found = false;
+            for (auto& prop : props)
+            {
+                if (strcmp(layer, prop.layerName) == 0)
+                {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found)
+                return false;
+        }
+
+        return true;
+    }
+    QueueFamiliesIndices getFamilies(const vk::PhysicalDevice& device)
+    {
+        std::vector<vk::QueueFamilyProperties> families = device.getQueueFamilyProperties();
+
+        QueueFamiliesIndices indeces;
+        uint32_t index = 0;
+        for (auto& family : families)
+        {
+            if (family.queueFlags & vk::QueueFlagBits::eGraphics)
+                indeces.graphicsFamily = index;
+            if (device.getSurfaceSupportKHR(index, surface))
+                indeces.presentationFamily = index;
+
+            if (indeces)
+                break;
+            index++;
+        }
+
+        return indeces;
+    }
+    inline SurfaceDetails getSurfaceDetail(const vk::PhysicalDevice& device)
+    {
+        return {
+            device.getSurfaceCapabilitiesKHR(surface),
+            device.getSurfaceFormatsKHR(surface),
+            device.getSurfacePresentModesKHR(surface)
+        };
+    }
+    inline vk::ImageView createImageView(vk::Image image, vk::ImageViewType type,vk::Format format, uint32_t mipLevels = 1)
+    {
+        vk::ImageViewCreateInfo viewInfo;
+
+        viewInfo.setImage(image)
+            .setFormat(format)
+            .setViewType(type)
+            .setSubresourceRange({ vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, 1 });
+
+        return device.createImageView(viewInfo);
+    }
+private:
+    AppDesc appDesc;
+    GLFWwindow* window;
+
+    VulkanRenderInstance* renderInstance;
+    VulkanRenderDevice* renderDevice;
+
+    vk::Device device;
+
+    vk::SurfaceKHR surface;
+
+    VulkanRenderGraph* renderGraph;
+    uint32_t swapchainGeneration;
+
+    struct 
+    {
+        vk::Queue graphicsQueue; 
+        vk::Queue presentationQueue;
+    } queues;
+
+    struct
+    {
+        Image* handle;
+        ImageView* view;
+
+        ImageFormat format = ImageFormat::RGBA8;
+        uint32_t width, height;
+        uint32_t mipLevels = 1;
+    } image;
+
+    vk::Sampler sampler;
+
+    vk::RenderPass renderPass;
+    VulkanPipelineManager* pipelineManager;
+    PipelineHandle pipeline;
+    VulkanShaderProgram* shaderProgram;
+    // Owned by the device's layout cache
+    vk::PipelineLayout pipelineLayout;
+    std::vector<std::string> shaderPaths;
+
+    FileWatcher* shaderWatcher = nullptr;
+    std::future<VulkanShaderProgram*> pendingProgram;
+    ShaderPipeline reloading;
+    std::vector<RetiredPipeline> retiredPipelines;
+
+    VulkanDescriptorAllocator* descriptorAllocator = nullptr;
+    vk::DescriptorSet descriptorSet;
+
+    // Owned by the device, null when bindless is off
+    VulkanBindlessHeap* bindlessHeap = nullptr;
+    bool pushConstants = false;
+    // Null without instancing
+    VulkanInstanceBatcher* batcher = nullptr;
+    bool gpuCulling = false;
+    // Made with the descriptor sets, it needs the allocator
+    VulkanGpuCuller* culler = nullptr;
+    uint32_t textureIndex;
+    // The uniform ring's region of every frame
+    std::vector<uint32_t> objectBuffers;
+
+    VulkanUniformRing* uniformRing;
+    uint32_t objectCount;
+
+    VulkanUploader* uploader;
+
+    ThreadPool threadPool;
+    // Pipelines compile on their own workers, a long compilation never holds up the recording jobs
+    ThreadPool pipelineThreadPool{ 2 };
+    VulkanParallelRecorder* recorder;
+
+    std::vector<FrameData> frames;
+    // One per swapchain image : a present may wait on it until its image is acquired again, which the frame fences don't cover
+    std::vector<vk::Semaphore> renderFinishedSemaphores;
+    // Sets of a previous swapchain and the frameCount from which they can be destroyed
+    std::vector<std::pair<uint64_t, std::vector<vk::Semaphore>>> retiredRenderFinished;
+    std::vector<FrameStats> frameStats;
+    VulkanGpuProfiler* profiler = nullptr;
+    uint32_t currentFrame = 0;
+    uint64_t frameCount = 0;
+    FrameTimer frameTimer;
+
+    bool framebufferResized = false;
+
+    Buffer* vertexBuffer;
+    std::array<Vertex, 4> verteces{ {
+        {{-0.5,-0.5},{ 1  , 0  , 0  },{0,1}},
+        {{ 0.5,-0.5},{ 1  , 1  , 1  },{1,1}},
+        {{ 0.5, 0.5},{ 0  , 1  , 0  },{1,0}},
+        {{-0.5, 0.5},{ 0  , 0  , 1  },{0,0}},
+    } };
+    Buffer* indexBuffer;
+    std::array<uint32_t, 6> indeces{
+        0,1,2,
+        2,3,0
+    };
+
+
+        float currentRotation = 0;
+    #ifdef VALIDATION_LAYERS
+        vk::DebugUtilsMessengerEXT debugMessager;
+    #endif
+
+};
@@ -0,0 +1,239 @@
+#include "pch.h"
+#include "App.h"
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <map>
+
+/*
+	Runs the renderer headless for a fixed number of frames on a list of scenes and writes
+	the p50/p95/p99 of the frame, record, submit, gpu and per pass gpu times as JSON to a file (stdout is taken by the logs).
+
+	Benchmark.exe [--frames N] [--warmup N] [--output benchmark.json] [--scaling]
+		[--scene name:objects=N,texture=N,inflight=N,threads=N,bindless=0|1,push=0|1,instancing=0|1,culling=0|1]...
+
+	--scaling runs the same grid from 1k to 256k objects with one draw per object, with instancing and with gpu culling
+	instead of the default scenes, objectsPerSecond (objects / p50 frame time) shows how each path scales with the object count.
+*/
+
+struct BenchmarkScene
+{
+	std::string name;
+	AppDesc desc;
+};
+
+struct Percentiles
+{
+	double p50, p95, p99;
+};
+
+// Nearest rank percentiles
+static Percentiles ComputePercentiles(std::vector<double> values)
+{
+	std::sort(values.begin(), values.end());
+
+	auto at = [&](double p)
+	{
+		size_t rank = (size_t)std::ceil(p * values.size());
+		return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+	};
+
+	return { at(0.50), at(0.95), at(0.99) };
+}
+
+static std::string ToJson(const std::vector<double>& values)
+{
+	if (values.empty())
+		return "null";
+
+	Percentiles p = ComputePercentiles(values);
+
+	char buffer[128];
+	snprintf(buffer, sizeof(buffer), "{ \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f }", p.p50, p.p95, p.p99);
+	return buffer;
+}
+
+// At the p50 frame time
+static std::string ObjectsPerSecond(uint32_t objectCount, const std::vector<double>& frameTimes)
+{
+	if (frameTimes.empty())
+		return "null";
+
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.0f", objectCount * 1000.0 / ComputePercentiles(frameTimes).p50);
+	return buffer;
+}
+
+static std::vector<BenchmarkScene> GetDefaultScenes()
+{
+	std::vector<BenchmarkScene> scenes(8);
+
+	scenes[0].name = "single";
+	scenes[1].name = "grid_1k";
+	scenes[1].desc.objectCount = 1000;
+	scenes[2].name = "grid_10k";
+	scenes[2].desc.objectCount = 10000;
+	scenes[3].name = "texture_4k";
+	scenes[3].desc.textureSize = 4096;
+	scenes[4].name = "single_buffered";
+	scenes[4].desc.framesInFlight = 1;
+	scenes[4].desc.objectCount = 1000;
+	scenes[5].name = "grid_10k_bindless";
+	scenes[5].desc.objectCount = 10000;
+	scenes[5].desc.bindless = true;
+	scenes[6].name = "grid_10k_push";
+	scenes[6].desc.objectCount = 10000;
+	scenes[6].desc.pushConstants = true;
+	scenes[7].name = "grid_100k_culled";
+	scenes[7].desc.objectCount = 100000;
+	scenes[7].desc.gpuCulling = true;
+
+	return scenes;
+}
+
+static std::vector<BenchmarkScene> GetScalingScenes()
+{
+	std::vector<BenchmarkScene> scenes;
+	for (uint32_t objects : { 1000, 4000, 16000, 64000, 256000 })
+	{
+		for (const char* path : { "draws_", "instanced_", "culled_" })
+		{
+			BenchmarkScene scene;
+			scene.name = path + std::to_string(objects / 1000) + "k";
+			scene.desc.objectCount = objects;
+			scene.desc.instancing = path[0] == 'i';
+			scene.desc.gpuCulling = path[0] == 'c';
+			// The cpu paths write every object every frame, past 64k only the culled one is worth running
+			if (objects > 64000 && !scene.desc.gpuCulling)
+				continue;
+			scenes.push_back(scene);
+		}
+	}
+	return scenes;
+}
+
+// name:key=value,key=value
+static BenchmarkScene ParseScene(const std::string& text)
+{
+	BenchmarkScene scene;
+
+	size_t colon = text.find(':');
+	scene.name = text.substr(0, colon);
+	if (colon == std::string::npos)
+		return scene;
+
+	std::stringstream stream(text.substr(colon + 1));
+	std::string entry;
+	while (std::getline(stream, entry, ','))
+	{
+		size_t equal = entry.find('=');
+		if (equal == std::string::npos)
+		{
+			LOG_WARN("Ignoring \"%s\" in scene \"%s\"", entry.c_str(), scene.name.c_str());
+			continue;
+		}
+
+		const std::string key = entry.substr(0, equal);
+		const uint32_t value = (uint32_t)strtoul(entry.c_str() + equal + 1, nullptr, 10);
+
+		if (key == "objects")			scene.desc.objectCount = value;
+		else if (key == "texture")		scene.desc.textureSize = value;
+		else if (key == "inflight")		scene.desc.framesInFlight = value;
+		else if (key == "threads")		scene.desc.threadCount = value;
+		else if (key == "bindless")		scene.desc.bindless = value != 0;
+		else if (key == "push")			scene.desc.pushConstants = value != 0;
+		else if (key == "instancing")	scene.desc.instancing = value != 0;
+		else if (key == "culling")		scene.desc.gpuCulling = value != 0;
+		else LOG_WARN("Unknown scene parameter \"%s\"", key.c_str());
+	}
+
+	return scene;
+}
+
+int main(int argc, char** argv)
+{
+	uint64_t frameCount = 500;
+	uint64_t warmupCount = 50;
+	std::string outputPath = "benchmark.json";
+	std::vector<BenchmarkScene> scenes;
+	bool scaling = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const bool hasValue = i + 1 < argc;
+
+		if (strcmp(argv[i], "--frames") == 0 && hasValue)		frameCount = strtoull(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--warmup") == 0 && hasValue)	warmupCount = strtoull(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--output") == 0 && hasValue)	outputPath = argv[++i];
+		else if (strcmp(argv[i], "--scene") == 0 && hasValue)	scenes.push_back(ParseScene(argv[++i]));
+		else if (strcmp(argv[i], "--scaling") == 0)				scaling = true;
+		else LOG_WARN("Unknown argument \"%s\"", argv[i]);
+	}
+	if (scaling)
+	{
+		std::vector<BenchmarkScene> scalingScenes = GetScalingScenes();
+		scenes.insert(scenes.end(), scalingScenes.begin(), scalingScenes.end());
+	}
+	if (scenes.empty())
+		scenes = GetDefaultScenes();
+
+	std::stringstream json;
+	json << "{\n  \"frames\": " << frameCount << ",\n  \"warmup\": " << warmupCount << ",\n  \"scenes\": [";
+
+	for (uint32_t s = 0; s < scenes.size(); s++)
+	{
+		BenchmarkScene& scene = scenes[s];
+		scene.desc.headless = true;
+		scene.desc.validation = false;
+		scene.desc.collectStats = true;
+		scene.desc.frameLimit = warmupCount + frameCount;
+
+		LOG_INFO("Running scene \"%s\"", scene.name.c_str());
+
+		App app(scene.desc);
+		app.Run();
+
+		// The first frames pay for pipeline creation, first uploads, driver warm up...
+		std::vector<double> frameTimes, recordTimes, submitTimes, gpuTimes;
+		std::map<std::string, std::vector<double>> passTimes;
+		const std::vector<FrameStats>& stats = app.GetFrameStats();
+		for (size_t i = warmupCount; i < stats.size(); i++)
+		{
+			frameTimes.push_back(stats[i].frameTime);
+			recordTimes.push_back(stats[i].recordTime);
+			submitTimes.push_back(stats[i].submitTime);
+			if (stats[i].gpuTime >= 0)
+				gpuTimes.push_back(stats[i].gpuTime);
+			for (const auto& pass : stats[i].passTimes)
+				passTimes[pass.name].push_back(pass.milliseconds);
+		}
+
+		json << (s ? "," : "") << "\n    {\n"
+			<< "      \"name\": \"" << scene.name << "\",\n"
+			<< "      \"objects\": " << scene.desc.objectCount << ",\n"
+			<< "      \"textureSize\": " << scene.desc.textureSize << ",\n"
+			<< "      \"framesInFlight\": " << scene.desc.framesInFlight << ",\n"
+			<< "      \"threads\": " << scene.desc.threadCount << ",\n"
+			<< "      \"instancing\": " << (scene.desc.instancing ? "true" : "false") << ",\n"
+			<< "      \"gpuCulling\": " << (scene.desc.gpuCulling ? "true" : "false") << ",\n"
+			<< "      \"objectsPerSecond\": " << ObjectsPerSecond(scene.desc.objectCount, frameTimes) << ",\n"
+			<< "      \"frameTime\": " << ToJson(frameTimes) << ",\n"
+			<< "      \"recordTime\": " << ToJson(recordTimes) << ",\n"
+			<< "      \"submitTime\": " << ToJson(submitTimes) << ",\n"
+			<< "      \"gpuTime\": " << ToJson(gpuTimes) << ",\n"
+			<< "      \"passes\": {";
+		bool first = true;
+		for (const auto& [pass, times] : passTimes)
+		{
+			json << (first ? "" : ",") << "\n        \"" << pass << "\": " << ToJson(times);
+			first = false;
+		}
+		json << (passTimes.empty() ? "}" : "\n      }") << "\n    }";
+	}
+	json << "\n  ]\n}\n";
+
+	std::ofstream file(outputPath, std::ios::trunc);
+	ASSERT(file.is_open(), "Failed to open \"%s\"", outputPath.c_str());
+	file << json.str();
+	LOG_INFO("Results written to \"%s\"", outputPath.c_str());
+}
@@ -4,5 +4,6 @@
 
 #include "Logging.h"
 
-#define DEBUG_ASSERT(x,f,...) if(!(x)) {LOG_ERROR(f,__VA_ARGS__); _BREAK();std::exit(-1);}
-#define ASSERT(x,f,...)		if(!(x)) {LOG_ERROR(f,__VA_ARGS__); _BREAK();std::exit(-1);}
\ No newline at end of file
+// The message is written out before breaking, asserts are never compiled out with the log level
+#define DEBUG_ASSERT(x,f,...) if(!(x)) {Logger::Log(LogLevel::Error,f,__VA_ARGS__); LOG_FLUSH(); _BREAK();std::exit(-1);}
+#define ASSERT(x,f,...)		if(!(x)) {Logger::Log(LogLevel::Error,f,__VA_ARGS__); LOG_FLUSH(); _BREAK();std::exit(-1);}
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "pch.h"
+#include "FileWatcher.h"
+#include "Tracing.h"
+#include <set>
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#elif defined(__linux__)
+	#include <sys/inotify.h>
+	#include <sys/eventfd.h>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
+static constexpr uint32_t WaitForever = UINT32_MAX;
+
+FileWatcher::FileWatcher(const std::vector<std::string>& paths, uint32_t debounceMs)
+	:m_DebounceMs(debounceMs)
+{
+	std::set<std::string> directories;
+	for (const auto& path : paths)
+	{
+		std::error_code error;
+		const std::filesystem::path absolute = std::filesystem::absolute(path, error);
+		directories.insert((error ? std::filesystem::path(path) : absolute).parent_path().string());
+
+		m_Files.push_back({ path, std::filesystem::last_write_time(path, error) });
+	}
+	m_Directories.assign(directories.begin(), directories.end());
+
+#if defined(_WIN32)
+	m_WakeHandle = (intptr_t)CreateEventA(nullptr, TRUE, FALSE, nullptr);
+	for (const auto& directory : m_Directories)
+	{
+		HANDLE handle = FindFirstChangeNotificationA(directory.c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+		if (handle == INVALID_HANDLE_VALUE)
+			LOG_WARN("Can't watch \"%s\"", directory.c_str());
+		else
+			m_DirectoryHandles.push_back((intptr_t)handle);
+	}
+#elif defined(__linux__)
+	m_Handle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	m_WakeHandle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	ASSERT(m_Handle >= 0 && m_WakeHandle >= 0, "Failed to create the file watcher");
+	for (const auto& directory : m_Directories)
+	{
+		if (inotify_add_watch((int)m_Handle, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE) < 0)
+			LOG_WARN("Can't watch \"%s\"", directory.c_str());
+	}
+#endif
+
+	m_Thread = std::thread([this]() { watch(); });
+}
+
+FileWatcher::~FileWatcher()
+{
+	m_Stop = true;
+#if defined(_WIN32)
+	SetEvent((HANDLE)m_WakeHandle);
+#elif defined(__linux__)
+	const uint64_t one = 1;
+	write((int)m_WakeHandle, &one, sizeof(one));
+#endif
+	m_Thread.join();
+
+#if defined(_WIN32)
+	for (intptr_t handle : m_DirectoryHandles)
+		FindCloseChangeNotification((HANDLE)handle);
+	CloseHandle((HANDLE)m_WakeHandle);
+#elif defined(__linux__)
+	close((int)m_Handle);
+	close((int)m_WakeHandle);
+#endif
+}
+
+bool FileWatcher::PollChanges(std::vector<std::string>& changed)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (m_Changed.empty())
+		return false;
+
+	changed.insert(changed.end(), m_Changed.begin(), m_Changed.end());
+	m_Changed.clear();
+	return true;
+}
+
+void FileWatcher::watch()
+{
+	TRACE_THREAD_NAME("File watcher");
+
+	while (!m_Stop)
+	{
+		if (!waitForChange(WaitForever))
+			continue;
+
+		// Let the editor finish saving
+		while (!m_Stop && waitForChange(m_DebounceMs))
+			;
+
+		checkFiles();
+	}
+}
+
+bool FileWatcher::waitForChange(uint32_t timeoutMs)
+{
+#if defined(_WIN32)
+	std::vector<HANDLE> handles = { (HANDLE)m_WakeHandle };
+	for (intptr_t handle : m_DirectoryHandles)
+		handles.push_back((HANDLE)handle);
+
+	const DWORD result = WaitForMultipleObjects((DWORD)handles.size(), handles.data(), FALSE, timeoutMs == WaitForever ? INFINITE : timeoutMs);
+	if (result <= WAIT_OBJECT_0 || result >= WAIT_OBJECT_0 + handles.size())
+		return false;
+
+	FindNextChangeNotification(handles[result - WAIT_OBJECT_0]);
+	return true;
+#elif defined(__linux__)
+	pollfd fds[2] = { { (int)m_Handle, POLLIN, 0 }, { (int)m_WakeHandle, POLLIN, 0 } };
+	if (poll(fds, 2, timeoutMs == WaitForever ? -1 : (int)timeoutMs) <= 0 || (fds[1].revents & POLLIN))
+		return false;
+
+	// Only the fact that something changed matters, the events themselves are dropped
+	alignas(inotify_event) char buffer[4096];
+	while (read((int)m_Handle, buffer, sizeof(buffer)) > 0)
+		;
+	return true;
+#else
+	// No notifications, the files are looked at twice a second
+	if (timeoutMs != WaitForever)
+		return false;
+	for (uint32_t i = 0; i < 10 && !m_Stop; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	return !m_Stop;
+#endif
+}
+
+void FileWatcher::checkFiles()
+{
+	for (auto& file : m_Files)
+	{
+		// A file being replaced may briefly not exist, it is picked up on the next change
+		std::error_code error;
+		const auto lastWrite = std::filesystem::last_write_time(file.path, error);
+		if (error || lastWrite == file.lastWrite)
+			continue;
+		file.lastWrite = lastWrite;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (std::find(m_Changed.begin(), m_Changed.end(), file.path) == m_Changed.end())
+			m_Changed.push_back(file.path);
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+#include <stdint.h>
+
+/*
+	Watches a set of files from a background thread and reports the ones whose modification time changed.
+	The thread sleeps on the OS notifications of the files' directories (inotify on Linux, change notifications on Windows)
+	and only looks at the files when one of the directories changed, other platforms poll.
+	Editors often save in several steps (truncate, write, rename), a change is only reported once the directory
+	stayed quiet for debounceMs.
+*/
+class FileWatcher
+{
+public:
+	FileWatcher(const std::vector<std::string>& paths, uint32_t debounceMs = 100);
+	~FileWatcher();
+
+	// Moves the paths changed since the last call into changed, never blocks
+	bool PollChanges(std::vector<std::string>& changed);
+private:
+	void watch();
+	// Waits for a change in one of the directories, false when the watcher stops
+	bool waitForChange(uint32_t timeoutMs);
+	void checkFiles();
+private:
+	struct WatchedFile
+	{
+		std::string path;
+		std::filesystem::file_time_type lastWrite;
+	};
+	std::vector<WatchedFile> m_Files;
+	std::vector<std::string> m_Directories;
+	uint32_t m_DebounceMs;
+
+	std::mutex m_Mutex;
+	std::vector<std::string> m_Changed;
+
+	std::atomic<bool> m_Stop{ false };
+	std::thread m_Thread;
+
+	// inotify and eventfd descriptors on Linux, change notifications and the stop event on Windows
+	intptr_t m_Handle = -1;
+	intptr_t m_WakeHandle = -1;
+	std::vector<intptr_t> m_DirectoryHandles;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+#include "Logging.h"
+
+// Measures the time between consecutive Tick() calls and logs the average every reportInterval seconds
+class FrameTimer
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	FrameTimer(double reportInterval = 1.0)
+		:m_ReportInterval(reportInterval)
+	{}
+
+	inline void Tick()
+	{
+		auto now = Clock::now();
+		if (m_Started)
+		{
+			m_LastFrameTime = std::chrono::duration<double, std::milli>(now - m_Last).count();
+			m_AccumulatedTime += m_LastFrameTime;
+			m_AccumulatedFrames++;
+			m_TotalFrames++;
+		}
+		m_Last = now;
+		m_Started = true;
+
+		if (m_AccumulatedTime >= m_ReportInterval * 1000.0)
+		{
+			m_AverageFrameTime = m_AccumulatedTime / m_AccumulatedFrames;
+			LOG_INFO("Frame time : %.3f ms (%.1f fps)", m_AverageFrameTime, 1000.0 / m_AverageFrameTime);
+
+			m_AccumulatedTime = 0;
+			m_AccumulatedFrames = 0;
+		}
+	}
+
+	inline double GetLastFrameTime() const { return m_LastFrameTime; }
+	inline double GetAverageFrameTime() const { return m_AverageFrameTime; }
+	inline uint64_t GetFrameCount() const { return m_TotalFrames; }
+private:
+	Clock::time_point m_Last;
+	bool m_Started = false;
+
+	double m_ReportInterval;
+	double m_AccumulatedTime = 0;
+	uint32_t m_AccumulatedFrames = 0;
+
+	double m_LastFrameTime = 0;
+	double m_AverageFrameTime = 0;
+	uint64_t m_TotalFrames = 0;
+};
@@ -0,0 +1,282 @@
+#include "pch.h"
+#include "Logging.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	class RecordPool;
+
+	struct LogRecord
+	{
+		// Long enough for validation messages, longer ones are cut
+		static constexpr uint32_t MaxLength = 4096;
+
+		// Link in the queue, then in the pool's free list once written
+		std::atomic<LogRecord*> next;
+		RecordPool* pool;
+		LogLevel level;
+		uint32_t length;
+		char text[MaxLength];
+	};
+
+	/*
+		Records of one thread, reused once the writer is done with them so logging doesn't allocate past the first messages.
+		The writer pushes records back on a lock free stack, the owning thread takes the whole stack when it runs out.
+		Pools are never freed, the pool of a thread that exits goes to the next thread that logs.
+	*/
+	class RecordPool
+	{
+	public:
+		// Owning thread only
+		LogRecord* Acquire()
+		{
+			if (!m_Free)
+				m_Free = m_Returned.exchange(nullptr, std::memory_order_acquire);
+
+			LogRecord* record = m_Free;
+			if (record)
+			{
+				m_Free = record->next.load(std::memory_order_relaxed);
+				return record;
+			}
+
+			record = new LogRecord();
+			record->pool = this;
+			return record;
+		}
+
+		// Writer thread
+		void Release(LogRecord* record)
+		{
+			LogRecord* head = m_Returned.load(std::memory_order_relaxed);
+			do
+			{
+				record->next.store(head, std::memory_order_relaxed);
+			} while (!m_Returned.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+		}
+	private:
+		LogRecord* m_Free = nullptr;
+		std::atomic<LogRecord*> m_Returned{ nullptr };
+	};
+
+	class PoolRegistry
+	{
+	public:
+		RecordPool* Take()
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_Idle.empty())
+				return new RecordPool();
+
+			RecordPool* pool = m_Idle.back();
+			m_Idle.pop_back();
+			return pool;
+		}
+
+		void Give(RecordPool* pool)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Idle.push_back(pool);
+		}
+	private:
+		std::mutex m_Mutex;
+		std::vector<RecordPool*> m_Idle;
+	};
+
+	PoolRegistry& GetPools()
+	{
+		static PoolRegistry pools;
+		return pools;
+	}
+
+	// Hands the pool over when its thread exits
+	struct ThreadRecords
+	{
+		RecordPool* pool = GetPools().Take();
+		~ThreadRecords() { GetPools().Give(pool); }
+	};
+
+	/*
+		Intrusive multi producer single consumer queue (Vyukov) : producers exchange the head and link the previous one,
+		the consumer walks from the tail. A producer preempted between the two steps only delays the consumer.
+	*/
+	class RecordQueue
+	{
+	public:
+		RecordQueue()
+			:m_Head(&m_Stub), m_Tail(&m_Stub)
+		{
+			m_Stub.next = nullptr;
+		}
+
+		void Push(LogRecord* record)
+		{
+			record->next.store(nullptr, std::memory_order_relaxed);
+			LogRecord* previous = m_Head.exchange(record, std::memory_order_acq_rel);
+			previous->next.store(record, std::memory_order_release);
+		}
+
+		// Consumer only, nullptr when empty (or when the next producer is mid push)
+		LogRecord* Pop()
+		{
+			LogRecord* tail = m_Tail;
+			LogRecord* next = tail->next.load(std::memory_order_acquire);
+
+			if (tail == &m_Stub)
+			{
+				if (!next)
+					return nullptr;
+				m_Tail = next;
+				tail = next;
+				next = next->next.load(std::memory_order_acquire);
+			}
+			if (next)
+			{
+				m_Tail = next;
+				return tail;
+			}
+			if (tail != m_Head.load(std::memory_order_acquire))
+				return nullptr;
+
+			// tail is the last record, the stub goes back in so that it can be handed out
+			Push(&m_Stub);
+			next = tail->next.load(std::memory_order_acquire);
+			if (next)
+			{
+				m_Tail = next;
+				return tail;
+			}
+			return nullptr;
+		}
+	private:
+		std::atomic<LogRecord*> m_Head;
+		LogRecord* m_Tail;
+		LogRecord m_Stub;
+	};
+
+	class LogWriter
+	{
+	public:
+		LogWriter()
+		{
+			m_Thread = std::thread([this]() { run(); });
+		}
+		~LogWriter()
+		{
+			m_Stop = true;
+			m_Wake.notify_one();
+			m_Thread.join();
+			drain();
+		}
+
+		void Push(LogRecord* record, bool urgent)
+		{
+			m_Pushed.fetch_add(1, std::memory_order_relaxed);
+			m_Queue.Push(record);
+			// The writer polls anyway, only errors are worth a wake up
+			if (urgent)
+				m_Wake.notify_one();
+		}
+
+		void Flush()
+		{
+			const uint64_t target = m_Pushed.load(std::memory_order_relaxed);
+			while (m_Written.load(std::memory_order_acquire) < target)
+			{
+				m_Wake.notify_one();
+				std::this_thread::yield();
+			}
+		}
+	private:
+		void run()
+		{
+			while (!m_Stop)
+			{
+				drain();
+
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Wake.wait_for(lock, std::chrono::milliseconds(5));
+			}
+		}
+
+		void drain()
+		{
+			uint64_t written = 0;
+			while (LogRecord* record = m_Queue.Pop())
+			{
+				write(*record);
+				record->pool->Release(record);
+				written++;
+			}
+
+			if (written)
+			{
+				fflush(stdout);
+				m_Written.fetch_add(written, std::memory_order_release);
+			}
+		}
+
+		static void write(const LogRecord& record)
+		{
+			const char* color = PRINT_COLOR_WHITE;
+			switch (record.level)
+			{
+			case LogLevel::Error:	color = PRINT_COLOR_RED; break;
+			case LogLevel::Warn:	color = PRINT_COLOR_YELLOW; break;
+			case LogLevel::Info:	color = PRINT_COLOR_GREEN; break;
+			default:				break;
+			}
+
+			fputs(color, stdout);
+			fwrite(record.text, 1, record.length, stdout);
+			fputs(PRINT_COLOR_WHITE "\n", stdout);
+		}
+	private:
+		RecordQueue m_Queue;
+		std::thread m_Thread;
+		std::atomic<bool> m_Stop{ false };
+
+		std::mutex m_Mutex;
+		std::condition_variable m_Wake;
+
+		std::atomic<uint64_t> m_Pushed{ 0 };
+		std::atomic<uint64_t> m_Written{ 0 };
+	};
+
+	LogWriter& GetWriter()
+	{
+		static LogWriter writer;
+		return writer;
+	}
+}
+
+void Logger::Log(LogLevel level, const char* format, ...)
+{
+	thread_local ThreadRecords threadRecords;
+	LogRecord* record = threadRecords.pool->Acquire();
+
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(record->text, LogRecord::MaxLength, format, args);
+	va_end(args);
+
+	if (length < 0)
+	{
+		record->pool->Release(record);
+		return;
+	}
+
+	record->level = level;
+	record->length = (uint32_t)std::min<int>(length, LogRecord::MaxLength - 1);
+
+	GetWriter().Push(record, level == LogLevel::Error);
+}
+
+void Logger::Flush()
+{
+	GetWriter().Flush();
+}
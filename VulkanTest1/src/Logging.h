@@ -1,15 +1,70 @@
 #pragma once
 
 #include <stdio.h>
-#include <string>
-
-#define PRINT_COLOR_WHITE	std::string("\x1b[0m" )
-#define PRINT_COLOR_GREEN	std::string("\x1b[32m")
-#define PRINT_COLOR_YELLOW	std::string("\x1b[33m")
-#define PRINT_COLOR_RED		std::string("\x1b[31m")
-#define PRINT_COLOR_MAGENTA	std::string("\x1b[35m")
-
-#define LOG_ERROR(f,...) printf((PRINT_COLOR_RED + f + PRINT_COLOR_WHITE + '\n').c_str(),__VA_ARGS__)
-#define LOG_WARN(f,...) printf((PRINT_COLOR_YELLOW + f + PRINT_COLOR_WHITE + '\n').c_str(),__VA_ARGS__)
-#define LOG_INFO(f,...) printf((PRINT_COLOR_GREEN + f + PRINT_COLOR_WHITE + '\n').c_str(),__VA_ARGS__)
-#define LOG_TRACE(f,...) printf((PRINT_COLOR_WHITE + f + '\n').c_str(),__VA_ARGS__)
\ No newline at end of file
+#include <stdint.h>
+#include <stdarg.h>
+
+#define PRINT_COLOR_WHITE	"\x1b[0m"
+#define PRINT_COLOR_GREEN	"\x1b[32m"
+#define PRINT_COLOR_YELLOW	"\x1b[33m"
+#define PRINT_COLOR_RED		"\x1b[31m"
+#define PRINT_COLOR_MAGENTA	"\x1b[35m"
+
+#define LOG_LEVEL_TRACE	0
+#define LOG_LEVEL_INFO	1
+#define LOG_LEVEL_WARN	2
+#define LOG_LEVEL_ERROR	3
+#define LOG_LEVEL_OFF	4
+
+// Messages below LOG_LEVEL are compiled out, their arguments aren't even evaluated
+#ifndef LOG_LEVEL
+	#ifdef NDEBUG
+		#define LOG_LEVEL LOG_LEVEL_INFO
+	#else
+		#define LOG_LEVEL LOG_LEVEL_TRACE
+	#endif
+#endif
+
+enum class LogLevel : uint8_t
+{
+	Trace = LOG_LEVEL_TRACE,
+	Info = LOG_LEVEL_INFO,
+	Warn = LOG_LEVEL_WARN,
+	Error = LOG_LEVEL_ERROR,
+};
+
+/*
+	Asynchronous logger : messages are formatted on the calling thread into a record from that thread's pool
+	and pushed on a lock free queue (a single atomic exchange), a background thread writes them to stdout
+	and gives the records back to their pool. Logging never takes a lock, allocates or waits for the console
+	once a thread's pool has grown to its usual number of records in flight.
+	Flush() blocks until everything logged before the call is written, ASSERT flushes before breaking.
+*/
+namespace Logger
+{
+	void Log(LogLevel level, const char* format, ...);
+	void Flush();
+}
+
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+	#define LOG_ERROR(f,...) Logger::Log(LogLevel::Error,f,__VA_ARGS__)
+#else
+	#define LOG_ERROR(f,...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+	#define LOG_WARN(f,...) Logger::Log(LogLevel::Warn,f,__VA_ARGS__)
+#else
+	#define LOG_WARN(f,...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+	#define LOG_INFO(f,...) Logger::Log(LogLevel::Info,f,__VA_ARGS__)
+#else
+	#define LOG_INFO(f,...) ((void)0)
+#endif
+#if LOG_LEVEL <= LOG_LEVEL_TRACE
+	#define LOG_TRACE(f,...) Logger::Log(LogLevel::Trace,f,__VA_ARGS__)
+#else
+	#define LOG_TRACE(f,...) ((void)0)
+#endif
+
+#define LOG_FLUSH() Logger::Flush()
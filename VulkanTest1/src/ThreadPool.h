@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <stdint.h>
+#include "Tracing.h"
+
+// Fixed set of worker threads, jobs get the index of the worker running them so they can use per thread resources
+class ThreadPool
+{
+public:
+	using Job = std::function<void(uint32_t threadIndex)>;
+
+	static inline uint32_t DefaultThreadCount()
+	{
+		// One core is left to the main thread, hardware_concurrency() is 0 when unknown
+		return std::max(2u, std::thread::hardware_concurrency()) - 1;
+	}
+
+	ThreadPool(uint32_t threadCount = DefaultThreadCount())
+	{
+		threadCount = std::max(threadCount, 1u);
+
+		m_Threads.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_Threads.emplace_back([this, i]() { work(i); });
+	}
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stop = true;
+		}
+		m_JobAvailable.notify_all();
+
+		for (auto& thread : m_Threads)
+			thread.join();
+	}
+
+	inline void Submit(Job job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Jobs.push_back(std::move(job));
+			m_Pending++;
+		}
+		m_JobAvailable.notify_one();
+	}
+	// Blocks until every submitted job is done
+	inline void Wait()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_AllDone.wait(lock, [this]() { return m_Pending == 0; });
+	}
+	// Runs f(index, threadIndex) for index in [0, count) and waits for all of them
+	template<typename F>
+	inline void ParallelFor(uint32_t count, F&& f)
+	{
+		for (uint32_t i = 0; i < count; i++)
+			Submit([&f, i](uint32_t threadIndex) { f(i, threadIndex); });
+		Wait();
+	}
+
+	inline uint32_t GetThreadCount() const { return (uint32_t)m_Threads.size(); }
+private:
+	void work(uint32_t threadIndex)
+	{
+		TRACE_THREAD_NAME("Worker " + std::to_string(threadIndex));
+
+		while (true)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_JobAvailable.wait(lock, [this]() { return m_Stop || !m_Jobs.empty(); });
+				if (m_Jobs.empty())
+					return;
+
+				job = std::move(m_Jobs.front());
+				m_Jobs.pop_front();
+			}
+
+			job(threadIndex);
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				if (--m_Pending == 0)
+					m_AllDone.notify_all();
+			}
+		}
+	}
+private:
+	std::vector<std::thread> m_Threads;
+	std::deque<Job> m_Jobs;
+	uint32_t m_Pending = 0;
+	bool m_Stop = false;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_JobAvailable, m_AllDone;
+};
@@ -0,0 +1,152 @@
+#include "pch.h"
+#include "Tracing.h"
+
+// Threads are numbered in the order they first record something, the trace viewer wants small integers
+static std::atomic<uint32_t> s_NextThreadId{ 0 };
+
+static void WriteEscaped(std::ofstream& file, const std::string& text)
+{
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\')
+			file << '\\';
+		file << c;
+	}
+}
+
+Tracer& Tracer::Get()
+{
+	static Tracer tracer;
+	return tracer;
+}
+
+Tracer::Tracer()
+	:m_Epoch(Clock::now())
+{}
+
+uint32_t Tracer::getThreadId()
+{
+	thread_local uint32_t id = s_NextThreadId++;
+	return id;
+}
+
+double Tracer::toMicroseconds(Clock::time_point time) const
+{
+	return std::chrono::duration<double, std::micro>(time - m_Epoch).count();
+}
+
+void Tracer::Configure(const std::string& path, uint64_t firstFrame, uint64_t frameCount)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	m_Path = path;
+	m_FirstFrame = firstFrame;
+	m_FrameCount = frameCount;
+	m_Events.clear();
+	m_Events.reserve(1 << 16);
+}
+
+void Tracer::NextFrame()
+{
+	const uint64_t frame = m_Frame++;
+	if (m_Path.empty() || !m_FrameCount)
+		return;
+
+	if (frame == m_FirstFrame)
+	{
+		m_Capturing = true;
+		LOG_INFO("Capturing a trace of %llu frames", (unsigned long long)m_FrameCount);
+	}
+	else if (frame == m_FirstFrame + m_FrameCount)
+	{
+		Flush();
+	}
+}
+
+void Tracer::Flush()
+{
+	if (!m_Capturing.exchange(false))
+		return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	write();
+	m_Events.clear();
+	// A single capture per configuration
+	m_Path.clear();
+}
+
+void Tracer::AddZone(const char* name, Clock::time_point start, Clock::time_point end)
+{
+	// Zones still open when the capture ended
+	if (!IsCapturing())
+		return;
+
+	const uint32_t thread = getThreadId();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Events.push_back({ name, 'X', false, thread, toMicroseconds(start), std::chrono::duration<double, std::micro>(end - start).count() });
+}
+
+void Tracer::AddGpuZone(const std::string& name, Clock::time_point start, Clock::time_point end)
+{
+	if (!IsCapturing())
+		return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Events.push_back({ name, 'X', true, 0, toMicroseconds(start), std::chrono::duration<double, std::micro>(end - start).count() });
+}
+
+void Tracer::AddCounter(const char* name, double value)
+{
+	const auto now = Clock::now();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Events.push_back({ name, 'C', false, 0, toMicroseconds(now), value });
+}
+
+void Tracer::SetThreadName(const std::string& name)
+{
+	const uint32_t thread = getThreadId();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_ThreadNames[thread] = name;
+}
+
+void Tracer::write()
+{
+	std::ofstream file(m_Path, std::ios::trunc);
+	if (!file.is_open())
+	{
+		LOG_ERROR("Failed to open the trace file \"%s\"", m_Path.c_str());
+		return;
+	}
+
+	// CPU threads live in process 1, the gpu queue in process 2
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	file << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+	file << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":2,\"tid\":0,\"args\":{\"name\":\"GPU\"}},\n";
+	file << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":2,\"tid\":0,\"args\":{\"name\":\"Graphics queue\"}}";
+	for (const auto& [thread, name] : m_ThreadNames)
+	{
+		file << ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << thread << ",\"args\":{\"name\":\"";
+		WriteEscaped(file, name);
+		file << "\"}}";
+	}
+
+	file.precision(3);
+	file << std::fixed;
+	for (const auto& event : m_Events)
+	{
+		file << ",\n{\"ph\":\"" << event.phase << "\",\"name\":\"";
+		WriteEscaped(file, event.name);
+		file << "\",\"pid\":" << (event.gpu ? 2 : 1) << ",\"tid\":" << event.thread << ",\"ts\":" << event.timestamp;
+
+		if (event.phase == 'X')
+			file << ",\"dur\":" << event.value << "}";
+		else
+			file << ",\"args\":{\"value\":" << event.value << "}}";
+	}
+	file << "\n]}\n";
+
+	LOG_INFO("Trace written to \"%s\" (%u events)", m_Path.c_str(), (uint32_t)m_Events.size());
+}
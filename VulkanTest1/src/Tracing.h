@@ -0,0 +1,98 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>
+
+/*
+	Timeline instrumentation written as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+	Nothing is recorded outside of the configured frame window, a zone then costs an atomic load.
+	Inside the window events are appended under a lock and written to the file when the window ends
+	(or on Flush() if the application stops before).
+	CPU zones go to the track of the thread that recorded them, gpu zones to a separate "GPU" process
+	with times already converted to the steady clock.
+*/
+class Tracer
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static Tracer& Get();
+
+	// Records the frames [firstFrame, firstFrame + frameCount), frames are counted by NextFrame()
+	void Configure(const std::string& path, uint64_t firstFrame, uint64_t frameCount);
+	// Once per frame from the main thread, before the frame's work
+	void NextFrame();
+	void Flush();
+
+	inline bool IsCapturing() const { return m_Capturing.load(std::memory_order_relaxed); }
+
+	void AddZone(const char* name, Clock::time_point start, Clock::time_point end);
+	void AddGpuZone(const std::string& name, Clock::time_point start, Clock::time_point end);
+	void AddCounter(const char* name, double value);
+	// Kept across captures, threads name themselves once when they start
+	void SetThreadName(const std::string& name);
+private:
+	struct TraceEvent
+	{
+		std::string name;
+		char phase;
+		bool gpu;
+		uint32_t thread;
+		double timestamp;
+		// Duration for zones, value for counters
+		double value;
+	};
+
+	Tracer();
+
+	static uint32_t getThreadId();
+	double toMicroseconds(Clock::time_point time) const;
+	void write();
+private:
+	Clock::time_point m_Epoch;
+
+	std::mutex m_Mutex;
+	std::atomic<bool> m_Capturing{ false };
+	std::string m_Path;
+	uint64_t m_FirstFrame = 0;
+	uint64_t m_FrameCount = 0;
+	uint64_t m_Frame = 0;
+
+	std::vector<TraceEvent> m_Events;
+	std::map<uint32_t, std::string> m_ThreadNames;
+};
+
+// Measures the enclosing C++ scope, the name is copied when the zone ends
+class TraceZone
+{
+public:
+	TraceZone(const char* name)
+		:m_Name(name), m_Active(Tracer::Get().IsCapturing())
+	{
+		if (m_Active)
+			m_Start = Tracer::Clock::now();
+	}
+	~TraceZone()
+	{
+		if (m_Active)
+			Tracer::Get().AddZone(m_Name, m_Start, Tracer::Clock::now());
+	}
+	TraceZone(const TraceZone&) = delete;
+	TraceZone& operator=(const TraceZone&) = delete;
+private:
+	const char* m_Name;
+	bool m_Active;
+	Tracer::Clock::time_point m_Start;
+};
+
+#define TRACE_CONCAT_IMPL(a,b) a##b
+#define TRACE_CONCAT(a,b) TRACE_CONCAT_IMPL(a,b)
+
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone,__LINE__)(name)
+#define TRACE_COUNTER(name,value) if (Tracer::Get().IsCapturing()) Tracer::Get().AddCounter(name,value)
+#define TRACE_THREAD_NAME(name) Tracer::Get().SetThreadName(name)
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <initializer_list>
+
+// 64 bit FNV-1a, chain calls by passing the previous hash
+inline uint64_t Fnv1a(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+// boost::hash_combine
+template<typename T>
+inline void HashCombine(size_t& seed, const T& value)
+{
+	seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+struct FileChunk
+{
+	const void* data;
+	size_t size;
+};
+
+/*
+	Writes the chunks to a temporary file then renames it over path : readers either see the old file or the complete new one,
+	never a partial write. Every thread gets its own temporary file so concurrent writers of the same path don't mix their data.
+	On failure nothing is left behind and error tells why.
+*/
+inline bool ReplaceFile(const std::string& path, std::initializer_list<FileChunk> chunks, std::string& error)
+{
+	std::stringstream tmpName;
+	tmpName << path << "." << std::this_thread::get_id() << ".tmp";
+	const std::string tmpPath = tmpName.str();
+
+	std::error_code code;
+	{
+		std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+		for (const auto& chunk : chunks)
+			file.write((const char*)chunk.data, chunk.size);
+		file.flush();
+
+		if (!file)
+		{
+			error = "failed to write \"" + tmpPath + "\"";
+			file.close();
+			std::filesystem::remove(tmpPath, code);
+			return false;
+		}
+	}
+
+	std::filesystem::rename(tmpPath, path, code);
+	if (code)
+	{
+		error = code.message();
+		std::filesystem::remove(tmpPath, code);
+		return false;
+	}
+	return true;
+}
@@ -104,21 +104,61 @@ static constexpr inline vk::ImageAspectFlags GetVkImageAspect(ImageViewAspect as
     }
 }
 
+static inline vk::ImageUsageFlags GetVkImageUsage(ImageUsageFlags usage)
+{
+    constexpr vk::ImageUsageFlags null = {};
+
+    return    ((usage & ImageUsageBits::TransferSrc)            ? vk::ImageUsageFlagBits::eTransferSrc            : null)
+            | ((usage & ImageUsageBits::TransferDst)            ? vk::ImageUsageFlagBits::eTransferDst            : null)
+            | ((usage & ImageUsageBits::Sampled)                ? vk::ImageUsageFlagBits::eSampled                : null)
+            | ((usage & ImageUsageBits::Storage)                ? vk::ImageUsageFlagBits::eStorage                : null)
+            | ((usage & ImageUsageBits::ColorAttachment)        ? vk::ImageUsageFlagBits::eColorAttachment        : null)
+            | ((usage & ImageUsageBits::DepthStencilAttachment) ? vk::ImageUsageFlagBits::eDepthStencilAttachment : null);
+}
+static inline ImageUsageFlags GetImageUsage(vk::ImageUsageFlags usage)
+{
+    ImageUsageFlags result = ImageUsageBits::NoUse;
 
+    if (usage & vk::ImageUsageFlagBits::eTransferSrc)            result |= ImageUsageBits::TransferSrc;
+    if (usage & vk::ImageUsageFlagBits::eTransferDst)            result |= ImageUsageBits::TransferDst;
+    if (usage & vk::ImageUsageFlagBits::eSampled)                result |= ImageUsageBits::Sampled;
+    if (usage & vk::ImageUsageFlagBits::eStorage)                result |= ImageUsageBits::Storage;
+    if (usage & vk::ImageUsageFlagBits::eColorAttachment)        result |= ImageUsageBits::ColorAttachment;
+    if (usage & vk::ImageUsageFlagBits::eDepthStencilAttachment) result |= ImageUsageBits::DepthStencilAttachment;
 
+    return result;
+}
 
+static constexpr inline vk::ImageTiling GetVkTiling(ImageTiling tiling)
+{
+    switch (tiling)
+    {
+    case ImageTiling::Optimal:  return vk::ImageTiling::eOptimal;
+    case ImageTiling::Linear:   return vk::ImageTiling::eLinear;
+    }
+}
 
+static constexpr inline vk::ImageLayout GetVkInitialLayout(ImageInitialLayout layout)
+{
+    switch (layout)
+    {
+    case ImageInitialLayout::Undefined:         return vk::ImageLayout::eUndefined;
+    case ImageInitialLayout::Preinitialized:    return vk::ImageLayout::ePreinitialized;
+    }
+}
 
-
-
-
-
-
-
-
-
-
-
-
-
-
+static constexpr inline vk::SampleCountFlagBits GetVkSampleCount(uint32_t samples)
+{
+    switch (samples)
+    {
+    case 1:     return vk::SampleCountFlagBits::e1;
+    case 2:     return vk::SampleCountFlagBits::e2;
+    case 4:     return vk::SampleCountFlagBits::e4;
+    case 8:     return vk::SampleCountFlagBits::e8;
+    case 16:    return vk::SampleCountFlagBits::e16;
+    case 32:    return vk::SampleCountFlagBits::e32;
+    case 64:    return vk::SampleCountFlagBits::e64;
+    default:
+        ASSERT(false, "Unsupported sample count (%u)", samples);
+    }
+}
@@ -0,0 +1,142 @@
+#include "pch.h"
+#include "VulkanBindlessHeap.h"
+
+VulkanBindlessHeap::VulkanBindlessHeap(VulkanRenderDevice* device, const VulkanBindlessHeapDesc& desc)
+	:m_Device(device->getDevice()), m_FramesInFlight(desc.framesInFlight)
+{
+	ASSERT(device->hasDescriptorIndexing(), "The bindless heap needs VK_EXT_descriptor_indexing");
+
+	// Combined image samplers count as samplers and sampled images, every array is visible to every stage
+	const auto& limits = device->getDescriptorIndexingProperties();
+	const uint32_t textureLimit = std::min({ limits.maxDescriptorSetUpdateAfterBindSampledImages, limits.maxDescriptorSetUpdateAfterBindSamplers,
+		limits.maxPerStageDescriptorUpdateAfterBindSampledImages, limits.maxPerStageDescriptorUpdateAfterBindSamplers });
+	const uint32_t bufferLimit = std::min(limits.maxDescriptorSetUpdateAfterBindStorageBuffers, limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers);
+
+	const uint32_t resourceLimit = limits.maxPerStageUpdateAfterBindResources;
+
+	m_Buffers.name = "storage buffers";
+	m_Buffers.capacity = std::min({ desc.maxBuffers, bufferLimit, resourceLimit / 2 });
+	m_Textures.name = "textures";
+	m_Textures.capacity = std::min({ desc.maxTextures, textureLimit, resourceLimit - m_Buffers.capacity });
+
+	const std::array<vk::DescriptorSetLayoutBinding, 2> bindings = {
+		vk::DescriptorSetLayoutBinding(TextureBinding, vk::DescriptorType::eCombinedImageSampler, m_Textures.capacity, vk::ShaderStageFlagBits::eAll),
+		vk::DescriptorSetLayoutBinding(BufferBinding, vk::DescriptorType::eStorageBuffer, m_Buffers.capacity, vk::ShaderStageFlagBits::eAll),
+	};
+	const vk::DescriptorBindingFlagsEXT flags = vk::DescriptorBindingFlagBitsEXT::ePartiallyBound | vk::DescriptorBindingFlagBitsEXT::eUpdateAfterBind |
+		vk::DescriptorBindingFlagBitsEXT::eUpdateUnusedWhilePending;
+	const std::array<vk::DescriptorBindingFlagsEXT, 2> bindingFlags = { flags, flags };
+
+	// Not from the layout cache, it doesn't know about binding flags
+	auto flagsInfo = vk::DescriptorSetLayoutBindingFlagsCreateInfoEXT()
+		.setBindingCount(bindingFlags.size()).setPBindingFlags(bindingFlags.data());
+	m_SetLayout = m_Device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo()
+		.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPoolEXT)
+		.setBindingCount(bindings.size()).setPBindings(bindings.data())
+		.setPNext(&flagsInfo));
+
+	const std::array<vk::DescriptorPoolSize, 2> poolSizes = {
+		vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, m_Textures.capacity),
+		vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, m_Buffers.capacity),
+	};
+	m_Pool = m_Device.createDescriptorPool(vk::DescriptorPoolCreateInfo()
+		.setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBindEXT)
+		.setMaxSets(1)
+		.setPoolSizeCount(poolSizes.size()).setPPoolSizes(poolSizes.data()));
+
+	m_Set = m_Device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo()
+		.setDescriptorPool(m_Pool)
+		.setDescriptorSetCount(1).setPSetLayouts(&m_SetLayout))[0];
+
+	LOG_INFO("Bindless heap : %u textures, %u storage buffers", m_Textures.capacity, m_Buffers.capacity);
+}
+
+VulkanBindlessHeap::~VulkanBindlessHeap()
+{
+	m_Device.destroyDescriptorPool(m_Pool);
+	m_Device.destroyDescriptorSetLayout(m_SetLayout);
+}
+
+uint32_t VulkanBindlessHeap::AddTexture(vk::ImageView view, vk::Sampler sampler, vk::ImageLayout layout)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	const uint32_t index = allocate(m_Textures);
+
+	const auto imageInfo = vk::DescriptorImageInfo(sampler, view, layout);
+	m_Device.updateDescriptorSets(vk::WriteDescriptorSet()
+		.setDstSet(m_Set).setDstBinding(TextureBinding).setDstArrayElement(index)
+		.setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+		.setDescriptorCount(1).setPImageInfo(&imageInfo), {});
+
+	return index;
+}
+
+uint32_t VulkanBindlessHeap::AddStorageBuffer(vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize range)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	const uint32_t index = allocate(m_Buffers);
+
+	const auto bufferInfo = vk::DescriptorBufferInfo(buffer, offset, range);
+	m_Device.updateDescriptorSets(vk::WriteDescriptorSet()
+		.setDstSet(m_Set).setDstBinding(BufferBinding).setDstArrayElement(index)
+		.setDescriptorType(vk::DescriptorType::eStorageBuffer)
+		.setDescriptorCount(1).setPBufferInfo(&bufferInfo), {});
+
+	return index;
+}
+
+void VulkanBindlessHeap::RemoveTexture(uint32_t index)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	remove(m_Textures, index);
+}
+
+void VulkanBindlessHeap::RemoveStorageBuffer(uint32_t index)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	remove(m_Buffers, index);
+}
+
+void VulkanBindlessHeap::BeginFrame()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Frame++;
+
+	// Removed in frame n, the last frame that could read it is done once frame n + framesInFlight begins
+	for (Slots* slots : { &m_Textures, &m_Buffers })
+	{
+		auto& removed = slots->removed;
+		auto end = std::remove_if(removed.begin(), removed.end(), [&](const auto& entry)
+			{
+				if (m_Frame - entry.second < m_FramesInFlight)
+					return false;
+				slots->free.push_back(entry.first);
+				return true;
+			});
+		removed.erase(end, removed.end());
+	}
+}
+
+void VulkanBindlessHeap::Bind(vk::CommandBuffer commandBuffer, vk::PipelineBindPoint bindPoint, vk::PipelineLayout layout, uint32_t set) const
+{
+	commandBuffer.bindDescriptorSets(bindPoint, layout, set, m_Set, {});
+}
+
+uint32_t VulkanBindlessHeap::allocate(Slots& slots)
+{
+	if (!slots.free.empty())
+	{
+		const uint32_t index = slots.free.back();
+		slots.free.pop_back();
+		return index;
+	}
+
+	ASSERT(slots.next < slots.capacity, "The bindless heap is out of %s (%u)", slots.name, slots.capacity);
+	return slots.next++;
+}
+
+void VulkanBindlessHeap::remove(Slots& slots, uint32_t index)
+{
+	ASSERT(index < slots.next, "Invalid bindless index %u for %s", index, slots.name);
+	slots.removed.push_back({ index, m_Frame });
+}
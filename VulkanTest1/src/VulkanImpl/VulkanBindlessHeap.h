@@ -0,0 +1,71 @@
+#pragma once
+
+#include "VulkanImpl/VulkanRenderDevice.h"
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <mutex>
+
+struct VulkanBindlessHeapDesc
+{
+	uint32_t framesInFlight = 2;
+	// Clamped to the device's update after bind limits
+	uint32_t maxTextures = 4096;
+	uint32_t maxBuffers = 1024;
+};
+
+/*
+	One descriptor set holding every texture and storage buffer, shaders index it instead of getting their own sets :
+		layout(set = N, binding = 0) uniform sampler2D textures[];
+		layout(set = N, binding = 1) buffer Block { ... } buffers[];
+	Resources get an index when they are added and keep it until they are removed, the set is bound once per command buffer.
+	The arrays are partially bound and update after bind, adding a resource never disturbs the frames in flight.
+	A removed index is only handed out again once the frames that could still read it are done.
+*/
+class VulkanBindlessHeap
+{
+public:
+	static constexpr uint32_t TextureBinding = 0;
+	static constexpr uint32_t BufferBinding = 1;
+
+	VulkanBindlessHeap(VulkanRenderDevice* device, const VulkanBindlessHeapDesc& desc);
+	~VulkanBindlessHeap();
+
+	// The view must stay in layout until it is removed
+	uint32_t AddTexture(vk::ImageView view, vk::Sampler sampler, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+	uint32_t AddStorageBuffer(vk::Buffer buffer, vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE);
+	void RemoveTexture(uint32_t index);
+	void RemoveStorageBuffer(uint32_t index);
+
+	// Once per frame, after waiting for the frame's fence
+	void BeginFrame();
+	void Bind(vk::CommandBuffer commandBuffer, vk::PipelineBindPoint bindPoint, vk::PipelineLayout layout, uint32_t set = 0) const;
+public:
+	inline vk::DescriptorSetLayout getSetLayout() const { return m_SetLayout; }
+	inline vk::DescriptorSet getDescriptorSet() const { return m_Set; }
+	inline uint32_t getTextureCapacity() const { return m_Textures.capacity; }
+	inline uint32_t getBufferCapacity() const { return m_Buffers.capacity; }
+private:
+	struct Slots
+	{
+		const char* name;
+		uint32_t capacity;
+		uint32_t next = 0;
+		std::vector<uint32_t> free;
+		// Index and frame it was removed in
+		std::vector<std::pair<uint32_t, uint64_t>> removed;
+	};
+
+	uint32_t allocate(Slots& slots);
+	void remove(Slots& slots, uint32_t index);
+private:
+	vk::Device m_Device;
+	uint32_t m_FramesInFlight;
+
+	vk::DescriptorSetLayout m_SetLayout;
+	vk::DescriptorPool m_Pool;
+	vk::DescriptorSet m_Set;
+
+	std::mutex m_Mutex;
+	Slots m_Textures, m_Buffers;
+	uint64_t m_Frame = 0;
+};
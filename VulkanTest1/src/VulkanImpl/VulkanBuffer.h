@@ -1,11 +1,12 @@
 #pragma once
 
 #include "abstraction/Buffer.h"
+#include "VulkanImpl/VulkanMemoryAllocator.h"
 #include <vulkan/vulkan.hpp>
 
 struct VulkanBufferDesc : public BufferDesc
 {
-	vk::PhysicalDevice physicalDevice;
+	VulkanMemoryAllocator* allocator;
 	std::vector<uint32_t> queueFamilies;
 };
 
@@ -17,17 +18,26 @@ public:
 
 	virtual void* Map() override;
 	virtual void UnMap() override;
+
+	virtual void* GetMappedData() override;
+	virtual void Flush(size_t offset, size_t size) override;
+	virtual void Invalidate(size_t offset, size_t size) override;
 public:
-	inline vk::DeviceMemory getVkMemory() { return m_Memory; }
+	inline vk::DeviceMemory getVkMemory() { return m_Allocation.memory; }
+	inline vk::DeviceSize getVkMemoryOffset() { return m_Allocation.offset; }
 	inline vk::Buffer getVkBuffer() { return m_Buffer; }
+	inline vk::SharingMode getVkSharingMode() { return m_SharingMode; }
 	inline virtual const BufferDesc& GetDesc() const override { return m_Desc; }
 
 private:
 	vk::Device m_Device;
-	vk::DeviceMemory m_Memory;
+	VulkanMemoryAllocator* m_Allocator;
+	VulkanAllocation m_Allocation;
 	vk::Buffer m_Buffer;
+	vk::SharingMode m_SharingMode;
 
 	BufferDesc m_Desc;
 
-	bool m_DoFlush, m_DoInvalidate;
+	void* m_Mapped = nullptr;
+	bool m_DoFlush = false, m_DoInvalidate = false;
 };
\ No newline at end of file
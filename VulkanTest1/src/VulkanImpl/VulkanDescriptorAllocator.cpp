@@ -0,0 +1,217 @@
+#include "pch.h"
+#include "VulkanDescriptorAllocator.h"
+#include "Utils.h"
+
+// Descriptors per set reserved in every pool, by type
+static constexpr std::array<std::pair<vk::DescriptorType, float>, 11> PoolRatios = { {
+	{ vk::DescriptorType::eSampler, 0.5f },
+	{ vk::DescriptorType::eCombinedImageSampler, 4.f },
+	{ vk::DescriptorType::eSampledImage, 4.f },
+	{ vk::DescriptorType::eStorageImage, 1.f },
+	{ vk::DescriptorType::eUniformTexelBuffer, 1.f },
+	{ vk::DescriptorType::eStorageTexelBuffer, 1.f },
+	{ vk::DescriptorType::eUniformBuffer, 2.f },
+	{ vk::DescriptorType::eStorageBuffer, 2.f },
+	{ vk::DescriptorType::eUniformBufferDynamic, 1.f },
+	{ vk::DescriptorType::eStorageBufferDynamic, 1.f },
+	{ vk::DescriptorType::eInputAttachment, 0.5f },
+} };
+
+static inline bool IsBuffer(vk::DescriptorType type)
+{
+	return type == vk::DescriptorType::eUniformBuffer || type == vk::DescriptorType::eStorageBuffer ||
+		type == vk::DescriptorType::eUniformBufferDynamic || type == vk::DescriptorType::eStorageBufferDynamic;
+}
+
+// Only compares what the type uses
+static inline bool SameWrite(const VulkanDescriptorWrite& a, const VulkanDescriptorWrite& b)
+{
+	if (a.binding != b.binding || a.type != b.type)
+		return false;
+	if (IsBuffer(a.type))
+		return a.buffer == b.buffer;
+	return a.image == b.image;
+}
+
+static size_t HashWrites(vk::DescriptorSetLayout layout, const std::vector<VulkanDescriptorWrite>& writes)
+{
+	size_t hash = writes.size();
+	HashCombine(hash, (uint64_t)(VkDescriptorSetLayout)layout);
+	for (const auto& write : writes)
+	{
+		HashCombine(hash, write.binding);
+		HashCombine(hash, (uint32_t)write.type);
+		if (IsBuffer(write.type))
+		{
+			HashCombine(hash, (uint64_t)(VkBuffer)write.buffer.buffer);
+			HashCombine(hash, write.buffer.offset);
+			HashCombine(hash, write.buffer.range);
+		}
+		else
+		{
+			HashCombine(hash, (uint64_t)(VkImageView)write.image.imageView);
+			HashCombine(hash, (uint64_t)(VkSampler)write.image.sampler);
+			HashCombine(hash, (uint32_t)write.image.imageLayout);
+		}
+	}
+	return hash;
+}
+
+VulkanDescriptorAllocator::VulkanDescriptorAllocator(vk::Device device, uint32_t framesInFlight, uint32_t setsPerPool)
+	:m_Device(device), m_SetsPerPool(setsPerPool), m_Frames(framesInFlight)
+{
+	ASSERT(framesInFlight > 0 && setsPerPool > 0, "Invalid descriptor allocator parameters");
+}
+
+VulkanDescriptorAllocator::~VulkanDescriptorAllocator()
+{
+	for (auto& frame : m_Frames)
+		for (auto pool : frame.pools)
+			m_Device.destroyDescriptorPool(pool);
+	for (auto pool : m_Persistent.pools)
+		m_Device.destroyDescriptorPool(pool);
+	for (auto pool : m_FreePools)
+		m_Device.destroyDescriptorPool(pool);
+}
+
+void VulkanDescriptorAllocator::BeginFrame(uint32_t frameIndex)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	ASSERT(frameIndex < m_Frames.size(), "Frame index %u is out of range (%u frames)", frameIndex, (uint32_t)m_Frames.size());
+
+	m_CurrentFrame = frameIndex;
+	resetChain(m_Frames[frameIndex]);
+}
+
+vk::DescriptorSet VulkanDescriptorAllocator::AllocateTransient(vk::DescriptorSetLayout layout, const std::vector<VulkanDescriptorWrite>& writes)
+{
+	vk::DescriptorSet set;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		set = allocate(m_Frames[m_CurrentFrame], layout);
+		m_TransientSets++;
+	}
+	write(set, writes);
+	return set;
+}
+
+vk::DescriptorSet VulkanDescriptorAllocator::GetCachedSet(vk::DescriptorSetLayout layout, const std::vector<VulkanDescriptorWrite>& writes)
+{
+	const size_t hash = HashWrites(layout, writes);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	std::vector<CachedSet>& bucket = m_Cache[hash];
+	for (const auto& entry : bucket)
+	{
+		if (entry.layout == layout && std::equal(entry.writes.begin(), entry.writes.end(), writes.begin(), writes.end(), SameWrite))
+		{
+			m_CacheHits++;
+			return entry.set;
+		}
+	}
+
+	// Under the lock, another thread asking for the same set must not write it a second time
+	vk::DescriptorSet set = allocate(m_Persistent, layout);
+	write(set, writes);
+	bucket.push_back({ layout, writes, set });
+	m_CachedSetCount++;
+
+	return set;
+}
+
+void VulkanDescriptorAllocator::ResetCache()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	m_Cache.clear();
+	m_CachedSetCount = 0;
+	resetChain(m_Persistent);
+}
+
+DescriptorAllocatorStats VulkanDescriptorAllocator::GetStats()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return { m_PoolCount, m_CachedSetCount, m_CacheHits, m_TransientSets };
+}
+
+vk::DescriptorSet VulkanDescriptorAllocator::allocate(PoolChain& chain, vk::DescriptorSetLayout layout)
+{
+	auto allocInfo = vk::DescriptorSetAllocateInfo()
+		.setDescriptorSetCount(1).setPSetLayouts(&layout);
+
+	// A fresh pool can only fail if the set doesn't fit in a pool at all
+	for (uint32_t attempt = 0; attempt < 2; attempt++)
+	{
+		if (!chain.current)
+		{
+			chain.current = getPool();
+			chain.pools.push_back(chain.current);
+		}
+
+		allocInfo.setDescriptorPool(chain.current);
+		vk::DescriptorSet set;
+		// The pointer overload returns the error instead of throwing it
+		const vk::Result result = m_Device.allocateDescriptorSets(&allocInfo, &set);
+		if (result == vk::Result::eSuccess)
+			return set;
+
+		ASSERT(result == vk::Result::eErrorOutOfPoolMemory || result == vk::Result::eErrorFragmentedPool,
+			"Failed to allocate a descriptor set : %s", vk::to_string(result).c_str());
+		chain.current = nullptr;
+	}
+
+	ASSERT(false, "The descriptor set layout doesn't fit in a pool of %u sets", m_SetsPerPool);
+	return nullptr;
+}
+
+vk::DescriptorPool VulkanDescriptorAllocator::getPool()
+{
+	if (!m_FreePools.empty())
+	{
+		vk::DescriptorPool pool = m_FreePools.back();
+		m_FreePools.pop_back();
+		return pool;
+	}
+
+	std::vector<vk::DescriptorPoolSize> sizes;
+	for (const auto& [type, ratio] : PoolRatios)
+		sizes.push_back({ type, std::max(1u, (uint32_t)(ratio * m_SetsPerPool)) });
+
+	m_PoolCount++;
+	return m_Device.createDescriptorPool(vk::DescriptorPoolCreateInfo()
+		.setMaxSets(m_SetsPerPool)
+		.setPoolSizeCount(sizes.size()).setPPoolSizes(sizes.data()));
+}
+
+void VulkanDescriptorAllocator::resetChain(PoolChain& chain)
+{
+	for (auto pool : chain.pools)
+	{
+		m_Device.resetDescriptorPool(pool);
+		m_FreePools.push_back(pool);
+	}
+	chain.pools.clear();
+	chain.current = nullptr;
+}
+
+void VulkanDescriptorAllocator::write(vk::DescriptorSet set, const std::vector<VulkanDescriptorWrite>& writes)
+{
+	std::vector<vk::WriteDescriptorSet> vkWrites;
+	vkWrites.reserve(writes.size());
+	for (const auto& write : writes)
+	{
+		ASSERT(write.type != vk::DescriptorType::eUniformTexelBuffer && write.type != vk::DescriptorType::eStorageTexelBuffer,
+			"Texel buffers can't be written by the descriptor allocator (binding %u)", write.binding);
+
+		auto vkWrite = vk::WriteDescriptorSet()
+			.setDstSet(set).setDstBinding(write.binding).setDstArrayElement(0)
+			.setDescriptorCount(1).setDescriptorType(write.type);
+		if (IsBuffer(write.type))
+			vkWrite.setPBufferInfo(&write.buffer);
+		else
+			vkWrite.setPImageInfo(&write.image);
+		vkWrites.push_back(vkWrite);
+	}
+	m_Device.updateDescriptorSets(vkWrites, {});
+}
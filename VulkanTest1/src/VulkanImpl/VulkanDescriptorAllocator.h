@@ -0,0 +1,90 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+// One descriptor of a set, buffer is used by buffer types and image by image and sampler types
+struct VulkanDescriptorWrite
+{
+	uint32_t binding;
+	vk::DescriptorType type;
+	vk::DescriptorBufferInfo buffer;
+	vk::DescriptorImageInfo image;
+
+	static inline VulkanDescriptorWrite Buffer(uint32_t binding, vk::DescriptorType type, vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize range)
+	{
+		return { binding, type, { buffer, offset, range }, {} };
+	}
+	static inline VulkanDescriptorWrite Image(uint32_t binding, vk::DescriptorType type, vk::ImageView view, vk::Sampler sampler, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal)
+	{
+		return { binding, type, {}, { sampler, view, layout } };
+	}
+};
+
+struct DescriptorAllocatorStats
+{
+	uint32_t poolCount = 0;
+	uint32_t cachedSets = 0;
+	uint64_t cacheHits = 0;
+	uint64_t transientSets = 0;
+};
+
+/*
+	Hands out descriptor sets from chains of pools, a full (or fragmented) pool is never an error : the next one is used.
+	Sets are never freed one by one, which is what fragments pools :
+	- Transient sets live for one frame, the pools of a frame are reset as a whole by BeginFrame (its fence must be signaled).
+	- Cached sets are keyed by their layout and everything written in them, asking twice for the same resources
+	  gives the same set. They live until ResetCache(), which must be called (gpu idle) before their resources are destroyed.
+	Pools hold setsPerPool sets with room for a mix of descriptor types, emptied pools are reused instead of destroyed.
+	Thread safe.
+*/
+class VulkanDescriptorAllocator
+{
+public:
+	VulkanDescriptorAllocator(vk::Device device, uint32_t framesInFlight, uint32_t setsPerPool = 256);
+	~VulkanDescriptorAllocator();
+
+	// Resets the transient pools of the frame
+	void BeginFrame(uint32_t frameIndex);
+
+	vk::DescriptorSet AllocateTransient(vk::DescriptorSetLayout layout, const std::vector<VulkanDescriptorWrite>& writes);
+	vk::DescriptorSet GetCachedSet(vk::DescriptorSetLayout layout, const std::vector<VulkanDescriptorWrite>& writes);
+	void ResetCache();
+
+	DescriptorAllocatorStats GetStats();
+private:
+	struct PoolChain
+	{
+		std::vector<vk::DescriptorPool> pools;
+		vk::DescriptorPool current;
+	};
+	struct CachedSet
+	{
+		vk::DescriptorSetLayout layout;
+		std::vector<VulkanDescriptorWrite> writes;
+		vk::DescriptorSet set;
+	};
+
+	vk::DescriptorSet allocate(PoolChain& chain, vk::DescriptorSetLayout layout);
+	vk::DescriptorPool getPool();
+	void resetChain(PoolChain& chain);
+	void write(vk::DescriptorSet set, const std::vector<VulkanDescriptorWrite>& writes);
+private:
+	vk::Device m_Device;
+	uint32_t m_SetsPerPool;
+
+	std::mutex m_Mutex;
+	std::vector<PoolChain> m_Frames;
+	uint32_t m_CurrentFrame = 0;
+	PoolChain m_Persistent;
+	// Reset pools, ready to be used by any chain
+	std::vector<vk::DescriptorPool> m_FreePools;
+	uint32_t m_PoolCount = 0;
+
+	std::unordered_map<size_t, std::vector<CachedSet>> m_Cache;
+	uint32_t m_CachedSetCount = 0;
+	uint64_t m_CacheHits = 0;
+	uint64_t m_TransientSets = 0;
+};
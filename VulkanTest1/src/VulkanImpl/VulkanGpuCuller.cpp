@@ -0,0 +1,154 @@
+#include "pch.h"
+#include "VulkanGpuCuller.h"
+
+// Gribb-Hartmann, the planes point inside and are normalized so the distance to a sphere's center can be compared to its radius
+static void ExtractFrustumPlanes(const glm::mat4& m, glm::vec4 planes[6])
+{
+	auto row = [&](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+
+	planes[0] = row(3) + row(0);
+	planes[1] = row(3) - row(0);
+	planes[2] = row(3) + row(1);
+	planes[3] = row(3) - row(1);
+	// -w <= z, looser than the 0 <= z of a zero to one projection but never culls a visible object
+	planes[4] = row(3) + row(2);
+	planes[5] = row(3) - row(2);
+
+	for (int i = 0; i < 6; i++)
+		planes[i] /= glm::length(glm::vec3(planes[i]));
+}
+
+bool VulkanGpuCuller::IsSupported(VulkanRenderDevice* device)
+{
+	const vk::PhysicalDeviceFeatures& features = device->getFeatures();
+	return features.multiDrawIndirect && features.drawIndirectFirstInstance;
+}
+
+VulkanGpuCuller::VulkanGpuCuller(VulkanRenderDevice* device, VulkanDescriptorAllocator* descriptorAllocator, const VulkanGpuCullerDesc& desc)
+	:m_Device(device->getDevice()), m_DrawIndexedIndirectCount(device->getDrawIndexedIndirectCount()),
+	m_MaxObjects(desc.maxObjects), m_MaxDrawCount(device->getLimits().maxDrawIndirectCount)
+{
+	ASSERT(IsSupported(device), "Gpu culling needs the multiDrawIndirect and drawIndirectFirstInstance features");
+	ASSERT(desc.maxObjects && desc.framesInFlight, "Invalid gpu culler parameters");
+
+	// The packed count is only known on the gpu so that draw can't be split, the slots can
+	if (desc.maxObjects > m_MaxDrawCount)
+		m_DrawIndexedIndirectCount = nullptr;
+
+	VulkanShaderProgramDesc programDesc;
+	programDesc.stages = { desc.shader };
+	m_Program = new VulkanShaderProgram(device, programDesc);
+	ASSERT(m_Program->getStageFlags() == vk::ShaderStageFlagBits::eCompute, "The culling shader must be a single compute stage");
+
+	m_Pipeline = m_Device.createComputePipeline(device->getPipelineCache(), vk::ComputePipelineCreateInfo()
+		.setLayout(m_Program->getPipelineLayout())
+		.setStage(m_Program->getStages()[0])).value;
+
+	BufferDesc bufferDesc; {
+		bufferDesc.usage = BufferUsageBits::StorageBuffer | BufferUsageBits::TransferDst;
+		bufferDesc.size = sizeof(GpuCullObject) * desc.maxObjects;
+		bufferDesc.gpuAccessRate = ResourceAccessRate::Frequent;
+		bufferDesc.cpuAccessibility = ResourceAccessibilityBits::None;
+	}
+	m_Objects = static_cast<VulkanBuffer*>(device->CreateBuffer(bufferDesc));
+
+	// Only ever written by the gpu, the count is cleared with a fill
+	bufferDesc.usage = BufferUsageBits::StorageBuffer | BufferUsageBits::IndirectBuffer | BufferUsageBits::TransferDst;
+	bufferDesc.size = DrawsOffset + sizeof(vk::DrawIndexedIndirectCommand) * desc.maxObjects;
+	for (uint32_t i = 0; i < desc.framesInFlight; i++)
+	{
+		m_Draws.push_back(static_cast<VulkanBuffer*>(device->CreateBuffer(bufferDesc)));
+		m_Sets.push_back(descriptorAllocator->GetCachedSet(m_Program->getSetLayouts()[0], {
+			VulkanDescriptorWrite::Buffer(0, vk::DescriptorType::eStorageBuffer, m_Objects->getVkBuffer(), 0, VK_WHOLE_SIZE),
+			VulkanDescriptorWrite::Buffer(1, vk::DescriptorType::eStorageBuffer, m_Draws.back()->getVkBuffer(), 0, VK_WHOLE_SIZE),
+		}));
+	}
+
+	LOG_INFO("Gpu culling : up to %u objects, %s, up to %u draws per call", desc.maxObjects,
+		isCompacting() ? "packed draws with drawIndexedIndirectCount" : "one draw slot per object", m_MaxDrawCount);
+}
+
+VulkanGpuCuller::~VulkanGpuCuller()
+{
+	for (auto draws : m_Draws)
+		delete draws;
+	delete m_Objects;
+
+	m_Device.destroyPipeline(m_Pipeline);
+	delete m_Program;
+}
+
+void VulkanGpuCuller::SetObjects(VulkanUploader* uploader, const std::vector<GpuCullObject>& objects)
+{
+	ASSERT(objects.size() <= m_MaxObjects, "%u objects, the culler was made for %u", (uint32_t)objects.size(), m_MaxObjects);
+
+	m_ObjectCount = (uint32_t)objects.size();
+	if (objects.empty())
+		return;
+
+	// Read by the culling and by the vertex shaders
+	uploader->UploadBuffer(m_Objects, objects.data(), sizeof(GpuCullObject) * objects.size(), 0,
+		vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eVertexShader, vk::AccessFlagBits::eShaderRead);
+}
+
+RenderGraphResource VulkanGpuCuller::AddPasses(VulkanRenderGraph* graph, uint32_t frameIndex, const glm::mat4& viewProj)
+{
+	RenderGraphResource draws = graph->ImportBuffer("Draws", m_Draws[frameIndex]);
+	const vk::Buffer drawBuffer = m_Draws[frameIndex]->getVkBuffer();
+
+	// Only the count is used when packing, each slot is rewritten otherwise
+	if (isCompacting())
+	{
+		graph->AddPass("Reset draws", [&](VulkanRenderGraph::PassBuilder& builder)
+			{
+				builder.Write(draws, RenderGraphUsage::TransferDst);
+			},
+			[drawBuffer](const RenderGraphPassContext& context)
+			{
+				context.commandBuffer.fillBuffer(drawBuffer, 0, sizeof(uint32_t), 0);
+			});
+	}
+
+	CullConstants constants;
+	ExtractFrustumPlanes(viewProj, constants.planes);
+	constants.objectCount = m_ObjectCount;
+	constants.compact = isCompacting();
+
+	graph->AddPass("Cull", [&](VulkanRenderGraph::PassBuilder& builder)
+		{
+			builder.Write(draws, RenderGraphUsage::StorageWriteCompute);
+		},
+		[this, constants, frameIndex](const RenderGraphPassContext& context)
+		{
+			if (!m_ObjectCount)
+				return;
+
+			const vk::CommandBuffer commandBuffer = context.commandBuffer;
+			commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_Pipeline);
+			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_Program->getPipelineLayout(), 0, m_Sets[frameIndex], {});
+			commandBuffer.pushConstants(m_Program->getPipelineLayout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(constants), &constants);
+			// 64 objects per group
+			commandBuffer.dispatch((m_ObjectCount + 63) / 64, 1, 1);
+		});
+
+	return draws;
+}
+
+void VulkanGpuCuller::Draw(vk::CommandBuffer commandBuffer, uint32_t frameIndex) const
+{
+	if (!m_ObjectCount)
+		return;
+
+	const vk::Buffer drawBuffer = m_Draws[frameIndex]->getVkBuffer();
+	constexpr uint32_t stride = sizeof(vk::DrawIndexedIndirectCommand);
+
+	if (m_DrawIndexedIndirectCount)
+	{
+		m_DrawIndexedIndirectCount((VkCommandBuffer)commandBuffer, (VkBuffer)drawBuffer, DrawsOffset, (VkBuffer)drawBuffer, 0, m_ObjectCount, stride);
+		return;
+	}
+
+	// Slots past maxDrawIndirectCount go in more calls
+	for (uint32_t first = 0; first < m_ObjectCount; first += m_MaxDrawCount)
+		commandBuffer.drawIndexedIndirect(drawBuffer, DrawsOffset + (vk::DeviceSize)first * stride, std::min(m_ObjectCount - first, m_MaxDrawCount), stride);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "VulkanImpl/VulkanRenderDevice.h"
+#include "VulkanImpl/VulkanShaderProgram.h"
+#include "VulkanImpl/VulkanDescriptorAllocator.h"
+#include "VulkanImpl/VulkanRenderGraph.h"
+#include "VulkanImpl/VulkanUploader.h"
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Matches the Object of cull.comp
+struct GpuCullObject
+{
+	// World space center and radius of the bounds
+	glm::vec4 sphere;
+	uint32_t indexCount;
+	uint32_t firstIndex;
+	int32_t vertexOffset;
+	uint32_t padding = 0;
+};
+
+struct VulkanGpuCullerDesc
+{
+	// SPIR-V of res/shaders/cull.comp
+	std::vector<uint32_t> shader;
+	uint32_t maxObjects = 0;
+	uint32_t framesInFlight = 2;
+};
+
+/*
+	Frustum culls objects on the gpu and draws the visible ones with indirect draws, the cpu cost doesn't depend on the object count.
+	The objects live in a storage buffer (the vertex shaders can read it too), every frame has its own draw buffer :
+	the draw count then, 16 bytes in, one VkDrawIndexedIndirectCommand per object with the object as its first instance.
+	With VK_KHR_draw_indirect_count the visible draws are packed and counted on the gpu and a single drawIndexedIndirectCount
+	draws them, otherwise culled objects keep their slot with no instance and drawIndexedIndirect goes through every slot,
+	in several calls when there are more slots than maxDrawIndirectCount (packing is off then, the gpu count can't be split).
+	Runs on the graphics queue in the frame's graph, the device needs multiDrawIndirect and drawIndirectFirstInstance (IsSupported).
+*/
+class VulkanGpuCuller
+{
+public:
+	VulkanGpuCuller(VulkanRenderDevice* device, VulkanDescriptorAllocator* descriptorAllocator, const VulkanGpuCullerDesc& desc);
+	~VulkanGpuCuller();
+
+	static bool IsSupported(VulkanRenderDevice* device);
+
+	// Uploaded through the uploader, ready for the first frame once it is submitted
+	void SetObjects(VulkanUploader* uploader, const std::vector<GpuCullObject>& objects);
+
+	// Resets the frame's draw buffer and culls into it, the pass drawing it must Read the returned buffer as an IndirectBuffer
+	RenderGraphResource AddPasses(VulkanRenderGraph* graph, uint32_t frameIndex, const glm::mat4& viewProj);
+	// With the pipeline and the vertex and index buffers bound
+	void Draw(vk::CommandBuffer commandBuffer, uint32_t frameIndex) const;
+public:
+	inline vk::Buffer getObjectBuffer() const { return m_Objects->getVkBuffer(); }
+	inline uint32_t getObjectCount() const { return m_ObjectCount; }
+	inline bool isCompacting() const { return m_DrawIndexedIndirectCount != nullptr; }
+private:
+	// Matches the push constants of cull.comp
+	struct CullConstants
+	{
+		glm::vec4 planes[6];
+		uint32_t objectCount;
+		uint32_t compact;
+	};
+	static constexpr vk::DeviceSize DrawsOffset = 16;
+private:
+	vk::Device m_Device;
+	PFN_vkCmdDrawIndexedIndirectCountKHR m_DrawIndexedIndirectCount;
+
+	VulkanShaderProgram* m_Program;
+	vk::Pipeline m_Pipeline;
+
+	uint32_t m_MaxObjects;
+	uint32_t m_MaxDrawCount;
+	uint32_t m_ObjectCount = 0;
+	VulkanBuffer* m_Objects;
+	std::vector<VulkanBuffer*> m_Draws;
+	std::vector<vk::DescriptorSet> m_Sets;
+};
@@ -0,0 +1,158 @@
+#include "pch.h"
+#include "VulkanGpuProfiler.h"
+
+VulkanGpuProfiler::VulkanGpuProfiler(VulkanRenderDevice* device, uint32_t framesInFlight, uint32_t maxScopesPerFrame)
+	:m_RenderDevice(device), m_Device(device->getDevice()), m_MaxScopes(maxScopesPerFrame), m_Frames(framesInFlight)
+{
+	const uint32_t validBits = device->getPhysicalDevice().getQueueFamilyProperties()[device->getGraphicsFamily()].timestampValidBits;
+	if (!validBits)
+	{
+		LOG_WARN("The graphics queue doesn't support timestamps, gpu profiling is disabled");
+		return;
+	}
+
+	// The bits above timestampValidBits are undefined, deltas are computed modulo the valid range
+	m_TimestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+	m_Period = device->getLimits().timestampPeriod;
+
+	m_Pool = m_Device.createQueryPool(vk::QueryPoolCreateInfo()
+		.setQueryType(vk::QueryType::eTimestamp)
+		.setQueryCount(framesInFlight * maxScopesPerFrame * 2));
+}
+
+VulkanGpuProfiler::~VulkanGpuProfiler()
+{
+	m_Device.destroyQueryPool(m_Pool);
+}
+
+void VulkanGpuProfiler::BeginFrame(uint32_t frameIndex, vk::CommandBuffer commandBuffer)
+{
+	ASSERT(frameIndex < m_Frames.size(), "Frame index %u is out of range (%u frames)", frameIndex, (uint32_t)m_Frames.size());
+	ASSERT(m_OpenScopes.empty(), "%u gpu scopes of the previous frame were not ended", (uint32_t)m_OpenScopes.size());
+
+	FrameQueries& frame = m_Frames[frameIndex];
+	if (frame.pending && !Resolve(frameIndex))
+		LOG_WARN("Dropping the gpu timings of frame %u, its queries are not available", frameIndex);
+
+	m_CurrentFrame = frameIndex;
+	m_Overflowed = false;
+	frame.scopes.clear();
+	frame.pending = false;
+
+	if (m_Pool)
+		commandBuffer.resetQueryPool(m_Pool, frameIndex * m_MaxScopes * 2, m_MaxScopes * 2);
+}
+
+bool VulkanGpuProfiler::Resolve(uint32_t frameIndex)
+{
+	FrameQueries& frame = m_Frames[frameIndex];
+	if (!m_Pool || !frame.pending)
+		return false;
+
+	if (frame.scopes.empty())
+	{
+		frame.pending = false;
+		m_Results.clear();
+		m_Calibrated = false;
+		return true;
+	}
+
+	// Each query comes with its availability, nothing blocks if the gpu isn't there yet
+	struct QueryResult
+	{
+		uint64_t value;
+		uint64_t available;
+	};
+	std::vector<QueryResult> queries(frame.scopes.size() * 2);
+
+	vk::Result result = m_Device.getQueryPoolResults(m_Pool, frameIndex * m_MaxScopes * 2, (uint32_t)queries.size(),
+		queries.size() * sizeof(QueryResult), queries.data(), sizeof(QueryResult),
+		vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+	if (result != vk::Result::eSuccess && result != vk::Result::eNotReady)
+		return false;
+
+	for (uint32_t i = 0; i < frame.scopes.size(); i++)
+	{
+		if (frame.scopes[i].ended && !(queries[i * 2].available && queries[i * 2 + 1].available))
+			return false;
+	}
+
+	const uint64_t frameStart = queries[0].value;
+
+	m_Results.clear();
+	for (uint32_t i = 0; i < frame.scopes.size(); i++)
+	{
+		const ScopeRecord& scope = frame.scopes[i];
+		if (!scope.ended)
+			continue;
+
+		const uint64_t start = (queries[i * 2].value - frameStart) & m_TimestampMask;
+		const uint64_t ticks = (queries[i * 2 + 1].value - queries[i * 2].value) & m_TimestampMask;
+		m_Results.push_back({ scope.name, scope.depth, start * m_Period / 1e6, ticks * m_Period / 1e6 });
+	}
+
+	// The frame is done, the counter sampled now is past all of its timestamps
+	uint64_t nowTicks;
+	std::chrono::steady_clock::time_point now;
+	m_Calibrated = m_RenderDevice->getCalibratedTimestamp(nowTicks, now);
+	if (m_Calibrated)
+	{
+		const double elapsed = ((nowTicks - frameStart) & m_TimestampMask) * m_Period;
+		m_FrameStart = now - std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::nano>(elapsed));
+	}
+
+	frame.pending = false;
+	return true;
+}
+
+uint32_t VulkanGpuProfiler::BeginScope(vk::CommandBuffer commandBuffer, const std::string& name, vk::PipelineStageFlagBits stage)
+{
+	if (!m_Pool)
+		return UINT32_MAX;
+
+	FrameQueries& frame = m_Frames[m_CurrentFrame];
+	if (frame.scopes.size() == m_MaxScopes)
+	{
+		if (!m_Overflowed)
+			LOG_WARN("More than %u gpu scopes in a frame, \"%s\" and the following ones are not measured", m_MaxScopes, name.c_str());
+		m_Overflowed = true;
+		return UINT32_MAX;
+	}
+
+	const uint32_t scope = (uint32_t)frame.scopes.size();
+	frame.scopes.push_back({ name, (uint32_t)m_OpenScopes.size() });
+	frame.pending = true;
+	m_OpenScopes.push_back(scope);
+
+	commandBuffer.writeTimestamp(stage, m_Pool, (m_CurrentFrame * m_MaxScopes + scope) * 2);
+	return scope;
+}
+
+void VulkanGpuProfiler::EndScope(vk::CommandBuffer commandBuffer, uint32_t scope, vk::PipelineStageFlagBits stage)
+{
+	if (scope == UINT32_MAX)
+		return;
+
+	ASSERT(!m_OpenScopes.empty() && m_OpenScopes.back() == scope, "Gpu scopes must be ended in the reverse order they were begun");
+	m_OpenScopes.pop_back();
+
+	m_Frames[m_CurrentFrame].scopes[scope].ended = true;
+	commandBuffer.writeTimestamp(stage, m_Pool, (m_CurrentFrame * m_MaxScopes + scope) * 2 + 1);
+}
+
+bool VulkanGpuProfiler::GetFrameStartTime(std::chrono::steady_clock::time_point& time) const
+{
+	if (m_Calibrated)
+		time = m_FrameStart;
+	return m_Calibrated;
+}
+
+double VulkanGpuProfiler::GetScopeTime(const std::string& name) const
+{
+	for (const auto& result : m_Results)
+	{
+		if (result.name == name)
+			return result.milliseconds;
+	}
+	return -1;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "VulkanImpl/VulkanRenderDevice.h"
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <string>
+#include <chrono>
+
+struct GpuScopeTiming
+{
+	std::string name;
+	// 0 for the outermost scopes
+	uint32_t depth;
+	// From the beginning of the frame's first scope
+	double start;
+	double milliseconds;
+};
+
+/*
+	Measures named scopes of a frame's command buffers with timestamp queries.
+	Every frame in flight has its own range of queries, BeginFrame resets the range of a frame from its command buffer
+	and the results are read back with Resolve once the frame's fence is signaled, nothing ever waits on the queries.
+	Scopes can be nested, they are reported in the order they were begun.
+	When the queue family can't write timestamps the profiler does nothing and never resolves anything.
+*/
+class VulkanGpuProfiler
+{
+public:
+	// Ends the scope when going out of C++ scope
+	class Scope
+	{
+	public:
+		Scope(VulkanGpuProfiler* profiler, vk::CommandBuffer commandBuffer, const std::string& name)
+			:m_Profiler(profiler), m_CommandBuffer(commandBuffer)
+		{
+			m_Scope = m_Profiler ? m_Profiler->BeginScope(commandBuffer, name) : UINT32_MAX;
+		}
+		~Scope()
+		{
+			if (m_Profiler)
+				m_Profiler->EndScope(m_CommandBuffer, m_Scope);
+		}
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	private:
+		VulkanGpuProfiler* m_Profiler;
+		vk::CommandBuffer m_CommandBuffer;
+		uint32_t m_Scope;
+	};
+
+	VulkanGpuProfiler(VulkanRenderDevice* device, uint32_t framesInFlight, uint32_t maxScopesPerFrame = 64);
+	~VulkanGpuProfiler();
+
+	// Right after the command buffer is begun, the frame that last used this index must be done on the gpu
+	void BeginFrame(uint32_t frameIndex, vk::CommandBuffer commandBuffer);
+	// Publishes the timings of the last frame recorded with this index, returns false if there is nothing new to publish
+	bool Resolve(uint32_t frameIndex);
+
+	// Returns UINT32_MAX when the frame is out of queries, ending such a scope does nothing
+	uint32_t BeginScope(vk::CommandBuffer commandBuffer, const std::string& name, vk::PipelineStageFlagBits stage = vk::PipelineStageFlagBits::eTopOfPipe);
+	void EndScope(vk::CommandBuffer commandBuffer, uint32_t scope, vk::PipelineStageFlagBits stage = vk::PipelineStageFlagBits::eBottomOfPipe);
+
+	// Timings of the last resolved frame
+	inline const std::vector<GpuScopeTiming>& GetResults() const { return m_Results; }
+	// Time of the first scope with that name in the last resolved frame, negative if there is none
+	double GetScopeTime(const std::string& name) const;
+	// Steady clock time of the last resolved frame's first timestamp, false when the device can't calibrate its timestamps
+	bool GetFrameStartTime(std::chrono::steady_clock::time_point& time) const;
+
+	inline bool IsSupported() const { return (bool)m_Pool; }
+private:
+	struct ScopeRecord
+	{
+		std::string name;
+		uint32_t depth;
+		bool ended = false;
+	};
+	struct FrameQueries
+	{
+		std::vector<ScopeRecord> scopes;
+		// Recorded and not resolved yet
+		bool pending = false;
+	};
+private:
+	VulkanRenderDevice* m_RenderDevice;
+	vk::Device m_Device;
+	vk::QueryPool m_Pool;
+	uint32_t m_MaxScopes;
+	// Nanoseconds per tick
+	double m_Period = 0;
+	uint64_t m_TimestampMask = 0;
+
+	std::vector<FrameQueries> m_Frames;
+	uint32_t m_CurrentFrame = 0;
+	std::vector<uint32_t> m_OpenScopes;
+	bool m_Overflowed = false;
+
+	std::vector<GpuScopeTiming> m_Results;
+	std::chrono::steady_clock::time_point m_FrameStart;
+	bool m_Calibrated = false;
+};
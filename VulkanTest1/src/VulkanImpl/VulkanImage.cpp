@@ -5,25 +5,49 @@
 VulkanImage::VulkanImage(vk::Device device, const VulkanImageDesc& desc)
 	:m_Device(device),m_Owning(desc.owning)
 {
+    m_Desc = desc;
+    m_Format = GetVkFormat(desc.format);
+
     if (desc.preMadeHandle)
     {
         m_Image = desc.preMadeHandle;
-        m_Desc = desc;
     }
     else
     {
-        ASSERT(false, "Image creation not supported yet");
+        ASSERT(desc.allocator, "Creating an image needs an allocator");
+        ASSERT(ImageUsageFlags(desc.usage), "Inacceptable image usage : %u", desc.usage);
+        ASSERT(desc.mipLevels && desc.layers, "An image needs at least one mip level and one layer");
+
         vk::ImageCreateFlags flags = {};
 
         if (desc.type == ImageType::e2D && desc.layers >= 6) flags |= vk::ImageCreateFlagBits::eCubeCompatible;
         else if (desc.type == ImageType::e3D) flags |= vk::ImageCreateFlagBits::e2DArrayCompatible;
 
+        std::vector<uint32_t> queueFamilies(desc.queueFamilies.begin(), desc.queueFamilies.end());
+
         auto imageinfo = vk::ImageCreateInfo()
             .setArrayLayers(desc.layers)
             .setExtent({ desc.dimensions.width,desc.dimensions.height ,desc.dimensions.depth })
             .setFlags(flags)
-            .setFormat(GetVkFormat(desc.format))
-            .setImageType(GetVkType(desc.type));
+            .setFormat(m_Format)
+            .setImageType(GetVkType(desc.type))
+            .setMipLevels(desc.mipLevels)
+            .setSamples(GetVkSampleCount(desc.samples))
+            .setTiling(GetVkTiling(desc.tiling))
+            .setUsage(GetVkImageUsage(desc.usage))
+            .setInitialLayout(GetVkInitialLayout(desc.initialLayout))
+            .setSharingMode(queueFamilies.size() > 1 ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive)
+            .setQueueFamilyIndexCount(queueFamilies.size() > 1 ? queueFamilies.size() : 0)
+            .setPQueueFamilyIndices(queueFamilies.data());
+
+        m_Image = device.createImage(imageinfo);
+
+        vk::MemoryRequirements reqs = device.getImageMemoryRequirements(m_Image);
+
+        m_Allocator = desc.allocator;
+        m_Allocation = m_Allocator->Allocate(reqs, GetVkMemoryFlags(desc.cpuAccessibility, desc.gpuAccessRate), desc.tiling == ImageTiling::Optimal);
+
+        device.bindImageMemory(m_Image, m_Allocation.memory, m_Allocation.offset);
     }
 }
 
@@ -31,4 +55,6 @@ VulkanImage::~VulkanImage()
 {
     if (m_Owning && m_Image)
         m_Device.destroyImage(m_Image);
+    if (m_Allocator)
+        m_Allocator->Free(m_Allocation);
 }
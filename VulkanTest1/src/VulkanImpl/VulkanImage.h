@@ -1,6 +1,7 @@
 #pragma once
 
 #include "abstraction/Image.h"
+#include "VulkanImpl/VulkanMemoryAllocator.h"
 #include <vulkan/vulkan.hpp>
 
 struct VulkanImageDesc : ImageDesc
@@ -8,6 +9,9 @@ struct VulkanImageDesc : ImageDesc
 	std::set<uint32_t> queueFamilies;
 	vk::Image preMadeHandle = nullptr;
 	bool owning = true;
+
+	// Needed when the image is created (no preMadeHandle)
+	VulkanMemoryAllocator* allocator = nullptr;
 };
 
 class VulkanImage : public Image
@@ -21,11 +25,17 @@ public:
 
 public:
 	inline vk::Image getVkImage() { return m_Image; }
+	inline vk::Format getVkFormat() { return m_Format; }
+	inline vk::DeviceMemory getVkMemory() { return m_Allocation.memory; }
 	inline bool isOwning() { return m_Owning; }
 private:
 	vk::Device m_Device;
 	vk::Image m_Image;
+	vk::Format m_Format;
 	ImageDesc m_Desc;
 
+	VulkanMemoryAllocator* m_Allocator = nullptr;
+	VulkanAllocation m_Allocation;
+
 	bool m_Owning;
 };
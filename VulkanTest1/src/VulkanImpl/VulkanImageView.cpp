@@ -13,13 +13,12 @@ VulkanImageView::VulkanImageView(vk::Device device, const VulkanImageViewDesc& d
 	else
 	{
 		VulkanImage* image = (VulkanImage*)desc.image;
-		const ImageDesc& imageDesc = image->GetDesc();
 
 		auto viewInfo = vk::ImageViewCreateInfo()
 			.setImage(image->getVkImage())
-			.setFormat(GetVkFormat(imageDesc.format))
+			.setFormat(image->getVkFormat())
 			.setViewType(GetVkViewType(desc.type))
-			.setSubresourceRange({ GetVkImageAspect(desc.aspect),0,1,desc.baseLayer,desc.layers });
+			.setSubresourceRange({ GetVkImageAspect(desc.aspect),desc.baseMipLevel,desc.mipLevels,desc.baseLayer,desc.layers });
 
 		m_View = device.createImageView(viewInfo);
 	}
@@ -17,6 +17,7 @@ public:
 
 public:
 	inline const vk::ImageView& getVkView() { return m_View; }
+	inline Image* getImage() { return m_Desc.image; }
 private:
 	ImageViewDesc m_Desc;
 	bool m_Owning;
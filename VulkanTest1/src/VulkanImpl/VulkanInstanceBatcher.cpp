@@ -0,0 +1,96 @@
+#include "pch.h"
+#include "VulkanInstanceBatcher.h"
+#include "Utils.h"
+
+size_t VulkanInstanceBatcher::KeyHash::operator()(const DrawBatchKey& key) const
+{
+	size_t hash = 0;
+	HashCombine(hash, (uint64_t)(VkPipeline)key.pipeline);
+	HashCombine(hash, (uint64_t)(VkPipelineLayout)key.layout);
+	HashCombine(hash, (uint64_t)(VkDescriptorSet)key.material);
+	HashCombine(hash, (uint64_t)(VkBuffer)key.mesh.vertexBuffer);
+	HashCombine(hash, (uint64_t)(VkBuffer)key.mesh.indexBuffer);
+	HashCombine(hash, key.mesh.indexCount);
+	return hash;
+}
+
+VulkanInstanceBatcher::VulkanInstanceBatcher(uint32_t instanceStride)
+	:m_InstanceStride(instanceStride)
+{
+	ASSERT(instanceStride, "Instances need some data");
+}
+
+void VulkanInstanceBatcher::Begin()
+{
+	for (auto& group : m_Groups)
+	{
+		group.instances.clear();
+		group.count = 0;
+	}
+	m_Batches.clear();
+}
+
+void VulkanInstanceBatcher::Add(const DrawBatchKey& key, const void* instances, uint32_t count)
+{
+	auto [it, added] = m_GroupIndices.try_emplace(key, (uint32_t)m_Groups.size());
+	if (added)
+		m_Groups.push_back({ key, {}, 0 });
+
+	Group& group = m_Groups[it->second];
+	const char* bytes = (const char*)instances;
+	group.instances.insert(group.instances.end(), bytes, bytes + (size_t)count * m_InstanceStride);
+	group.count += count;
+}
+
+void VulkanInstanceBatcher::End(VulkanUniformRing* ring)
+{
+	m_InstanceBuffer = ring->getVkBuffer();
+
+	for (const auto& group : m_Groups)
+	{
+		if (!group.count)
+			continue;
+
+		UniformSlice slice = ring->Allocate(group.instances.size());
+		memcpy(slice.data, group.instances.data(), group.instances.size());
+		m_Batches.push_back({ group.key, slice.offset, group.count });
+	}
+
+	// Pipeline changes cost the most, then descriptor sets
+	std::sort(m_Batches.begin(), m_Batches.end(), [](const DrawBatch& a, const DrawBatch& b)
+		{
+			if (a.key.pipeline != b.key.pipeline)
+				return (VkPipeline)a.key.pipeline < (VkPipeline)b.key.pipeline;
+			return (VkDescriptorSet)a.key.material < (VkDescriptorSet)b.key.material;
+		});
+}
+
+void VulkanInstanceBatcher::Record(vk::CommandBuffer commandBuffer, uint32_t first, uint32_t count, const std::vector<uint32_t>& dynamicOffsets) const
+{
+	ASSERT(first + count <= m_Batches.size(), "Batches [%u, %u) are out of range (%u batches)", first, first + count, (uint32_t)m_Batches.size());
+
+	const DrawBatchKey* previous = nullptr;
+	for (uint32_t i = first; i < first + count; i++)
+	{
+		const DrawBatch& batch = m_Batches[i];
+		const DrawBatchKey& key = batch.key;
+		// Still compiling
+		if (!key.pipeline)
+			continue;
+
+		if (!previous || previous->pipeline != key.pipeline)
+			commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, key.pipeline);
+		if (!previous || previous->material != key.material || previous->layout != key.layout)
+			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, key.layout, 0, key.material, dynamicOffsets);
+		if (!previous || previous->mesh.indexBuffer != key.mesh.indexBuffer)
+			commandBuffer.bindIndexBuffer(key.mesh.indexBuffer, 0, vk::IndexType::eUint32);
+
+		// The instance offset changes with every batch
+		const std::array<vk::Buffer, 2> buffers = { key.mesh.vertexBuffer, m_InstanceBuffer };
+		const std::array<vk::DeviceSize, 2> offsets = { 0, batch.instanceOffset };
+		commandBuffer.bindVertexBuffers(0, buffers, offsets);
+
+		commandBuffer.drawIndexed(key.mesh.indexCount, batch.instanceCount, 0, 0, 0);
+		previous = &key;
+	}
+}
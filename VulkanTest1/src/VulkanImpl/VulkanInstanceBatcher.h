@@ -0,0 +1,81 @@
+#pragma once
+
+#include "VulkanImpl/VulkanUniformRing.h"
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <unordered_map>
+
+struct InstancedMesh
+{
+	vk::Buffer vertexBuffer;
+	vk::Buffer indexBuffer;
+	uint32_t indexCount;
+};
+
+// Everything the objects of a batch share
+struct DrawBatchKey
+{
+	vk::Pipeline pipeline;
+	vk::PipelineLayout layout;
+	// Bound to set 0 with the dynamic offsets given to Record
+	vk::DescriptorSet material;
+	InstancedMesh mesh;
+
+	inline bool operator==(const DrawBatchKey& other) const
+	{
+		return pipeline == other.pipeline && layout == other.layout && material == other.material &&
+			mesh.vertexBuffer == other.mesh.vertexBuffer && mesh.indexBuffer == other.mesh.indexBuffer && mesh.indexCount == other.mesh.indexCount;
+	}
+};
+
+struct DrawBatch
+{
+	DrawBatchKey key;
+	// Where the instances start in the ring, bound to vertex binding 1
+	vk::DeviceSize instanceOffset;
+	uint32_t instanceCount;
+};
+
+/*
+	Groups the objects of a frame by pipeline, material and mesh, every group is drawn with a single instanced draw.
+	Objects are added between Begin() and End() with their per instance data (instanceStride bytes each),
+	End() copies the data of each group contiguously into the current frame's region of the ring.
+	Batches are sorted by pipeline then material, Record() only binds what changes from one batch to the next.
+	Not thread safe, but several threads can Record() different ranges of batches once End() returned.
+*/
+class VulkanInstanceBatcher
+{
+public:
+	VulkanInstanceBatcher(uint32_t instanceStride);
+
+	void Begin();
+	void Add(const DrawBatchKey& key, const void* instances, uint32_t count = 1);
+	// Between the ring's BeginFrame and EndFrame
+	void End(VulkanUniformRing* ring);
+
+	// Draws the batches [first, first + count), the viewport and scissor are left to the caller
+	void Record(vk::CommandBuffer commandBuffer, uint32_t first, uint32_t count, const std::vector<uint32_t>& dynamicOffsets) const;
+public:
+	inline const std::vector<DrawBatch>& getBatches() const { return m_Batches; }
+	inline uint32_t getInstanceStride() const { return m_InstanceStride; }
+private:
+	struct KeyHash
+	{
+		size_t operator()(const DrawBatchKey& key) const;
+	};
+	struct Group
+	{
+		DrawBatchKey key;
+		std::vector<char> instances;
+		uint32_t count = 0;
+	};
+private:
+	uint32_t m_InstanceStride;
+
+	// Kept from frame to frame with their storage, the ones nothing was added to are skipped
+	std::vector<Group> m_Groups;
+	std::unordered_map<DrawBatchKey, uint32_t, KeyHash> m_GroupIndices;
+
+	vk::Buffer m_InstanceBuffer;
+	std::vector<DrawBatch> m_Batches;
+};
@@ -0,0 +1,90 @@
+#include "pch.h"
+#include "VulkanLayoutCache.h"
+#include "Utils.h"
+
+// Immutable samplers aren't part of the key, the layouts created here never use them
+static inline bool SameBinding(const vk::DescriptorSetLayoutBinding& a, const vk::DescriptorSetLayoutBinding& b)
+{
+	return a.binding == b.binding && a.descriptorType == b.descriptorType && a.descriptorCount == b.descriptorCount && a.stageFlags == b.stageFlags;
+}
+
+VulkanLayoutCache::VulkanLayoutCache(vk::Device device)
+	:m_Device(device)
+{}
+
+VulkanLayoutCache::~VulkanLayoutCache()
+{
+	for (const auto& [hash, entries] : m_PipelineLayouts)
+		for (const auto& entry : entries)
+			m_Device.destroyPipelineLayout(entry.layout);
+
+	for (const auto& [hash, entries] : m_SetLayouts)
+		for (const auto& entry : entries)
+			m_Device.destroyDescriptorSetLayout(entry.layout);
+}
+
+vk::DescriptorSetLayout VulkanLayoutCache::GetDescriptorSetLayout(std::vector<vk::DescriptorSetLayoutBinding> bindings)
+{
+	std::sort(bindings.begin(), bindings.end(), [](const auto& a, const auto& b) { return a.binding < b.binding; });
+
+	size_t hash = bindings.size();
+	for (const auto& binding : bindings)
+	{
+		ASSERT(!binding.pImmutableSamplers, "Immutable samplers are not supported by the layout cache");
+		HashCombine(hash, binding.binding);
+		HashCombine(hash, (uint32_t)binding.descriptorType);
+		HashCombine(hash, binding.descriptorCount);
+		HashCombine(hash, (uint32_t)binding.stageFlags);
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	std::vector<SetLayoutEntry>& bucket = m_SetLayouts[hash];
+	for (const auto& entry : bucket)
+	{
+		if (std::equal(entry.bindings.begin(), entry.bindings.end(), bindings.begin(), bindings.end(), SameBinding))
+			return entry.layout;
+	}
+
+	auto layoutInfo = vk::DescriptorSetLayoutCreateInfo()
+		.setBindingCount(bindings.size()).setPBindings(bindings.data());
+
+	vk::DescriptorSetLayout layout = m_Device.createDescriptorSetLayout(layoutInfo);
+	bucket.push_back({ std::move(bindings), layout });
+	m_SetLayoutCount++;
+
+	return layout;
+}
+
+vk::PipelineLayout VulkanLayoutCache::GetPipelineLayout(const std::vector<vk::DescriptorSetLayout>& setLayouts, const std::vector<vk::PushConstantRange>& pushConstants)
+{
+	// Set layouts come from this cache, equal handles mean equal layouts
+	size_t hash = setLayouts.size();
+	for (const auto& setLayout : setLayouts)
+		HashCombine(hash, (uint64_t)(VkDescriptorSetLayout)setLayout);
+	for (const auto& range : pushConstants)
+	{
+		HashCombine(hash, (uint32_t)range.stageFlags);
+		HashCombine(hash, range.offset);
+		HashCombine(hash, range.size);
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	std::vector<PipelineLayoutEntry>& bucket = m_PipelineLayouts[hash];
+	for (const auto& entry : bucket)
+	{
+		if (entry.setLayouts == setLayouts && entry.pushConstants == pushConstants)
+			return entry.layout;
+	}
+
+	auto layoutInfo = vk::PipelineLayoutCreateInfo()
+		.setSetLayoutCount(setLayouts.size()).setPSetLayouts(setLayouts.data())
+		.setPushConstantRangeCount(pushConstants.size()).setPPushConstantRanges(pushConstants.data());
+
+	vk::PipelineLayout layout = m_Device.createPipelineLayout(layoutInfo);
+	bucket.push_back({ setLayouts, pushConstants, layout });
+	m_PipelineLayoutCount++;
+
+	return layout;
+}
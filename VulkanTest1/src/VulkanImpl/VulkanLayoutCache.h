@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+/*
+	Deduplicates descriptor set layouts and pipeline layouts : identical descriptions get the same handle,
+	which also makes the layouts of different pipelines compatible for descriptor sets bound across them.
+	Lookups hash the description and compare it with the entries of the bucket.
+	The layouts live as long as the cache, they are never destroyed by their users. Thread safe.
+*/
+class VulkanLayoutCache
+{
+public:
+	VulkanLayoutCache(vk::Device device);
+	~VulkanLayoutCache();
+
+	// The bindings don't have to be sorted
+	vk::DescriptorSetLayout GetDescriptorSetLayout(std::vector<vk::DescriptorSetLayoutBinding> bindings);
+	vk::PipelineLayout GetPipelineLayout(const std::vector<vk::DescriptorSetLayout>& setLayouts, const std::vector<vk::PushConstantRange>& pushConstants);
+
+	inline uint32_t GetSetLayoutCount() const { return m_SetLayoutCount; }
+	inline uint32_t GetPipelineLayoutCount() const { return m_PipelineLayoutCount; }
+private:
+	struct SetLayoutEntry
+	{
+		std::vector<vk::DescriptorSetLayoutBinding> bindings;
+		vk::DescriptorSetLayout layout;
+	};
+	struct PipelineLayoutEntry
+	{
+		std::vector<vk::DescriptorSetLayout> setLayouts;
+		std::vector<vk::PushConstantRange> pushConstants;
+		vk::PipelineLayout layout;
+	};
+private:
+	vk::Device m_Device;
+	std::mutex m_Mutex;
+
+	std::unordered_map<size_t, std::vector<SetLayoutEntry>> m_SetLayouts;
+	std::unordered_map<size_t, std::vector<PipelineLayoutEntry>> m_PipelineLayouts;
+	uint32_t m_SetLayoutCount = 0;
+	uint32_t m_PipelineLayoutCount = 0;
+};
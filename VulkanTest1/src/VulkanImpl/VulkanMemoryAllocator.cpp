@@ -0,0 +1,324 @@
+#include "pch.h"
+#include "VulkanMemoryAllocator.h"
+#include <map>
+
+inline static vk::DeviceSize AlignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+inline static vk::DeviceSize AlignDown(vk::DeviceSize value, vk::DeviceSize alignment)
+{
+	return value / alignment * alignment;
+}
+
+class VulkanMemoryBlock
+{
+public:
+	VulkanMemoryBlock(vk::DeviceMemory memory, uint32_t memoryType, vk::DeviceSize size, vk::MemoryPropertyFlags properties, bool dedicated, bool optimalTiling)
+		:memory(memory), memoryType(memoryType), size(size), properties(properties), dedicated(dedicated), optimalTiling(optimalTiling)
+	{
+		freeRanges[0] = size;
+	}
+
+	// Best fit over the free ranges, the padding created by the alignment stays in the free list
+	bool allocate(vk::DeviceSize reqSize, vk::DeviceSize alignment, vk::DeviceSize& outOffset)
+	{
+		auto best = freeRanges.end();
+		vk::DeviceSize bestWaste = std::numeric_limits<vk::DeviceSize>::max();
+
+		for (auto it = freeRanges.begin(); it != freeRanges.end(); it++)
+		{
+			auto [offset, rangeSize] = *it;
+			vk::DeviceSize aligned = AlignUp(offset, alignment);
+
+			if (aligned + reqSize > offset + rangeSize)
+				continue;
+
+			vk::DeviceSize waste = rangeSize - reqSize;
+			if (waste < bestWaste)
+			{
+				best = it;
+				bestWaste = waste;
+				if (waste == 0) break;
+			}
+		}
+
+		if (best == freeRanges.end())
+			return false;
+
+		auto [offset, rangeSize] = *best;
+		vk::DeviceSize aligned = AlignUp(offset, alignment);
+		freeRanges.erase(best);
+
+		if (aligned > offset)
+			freeRanges[offset] = aligned - offset;
+		if (aligned + reqSize < offset + rangeSize)
+			freeRanges[aligned + reqSize] = offset + rangeSize - aligned - reqSize;
+
+		usedBytes += reqSize;
+		allocationCount++;
+		outOffset = aligned;
+		return true;
+	}
+	void free(vk::DeviceSize offset, vk::DeviceSize rangeSize)
+	{
+		const vk::DeviceSize freedBytes = rangeSize;
+
+		auto next = freeRanges.lower_bound(offset);
+
+		if (next != freeRanges.begin())
+		{
+			auto prev = std::prev(next);
+			if (prev->first + prev->second == offset)
+			{
+				offset = prev->first;
+				rangeSize += prev->second;
+				freeRanges.erase(prev);
+			}
+		}
+		if (next != freeRanges.end() && offset + rangeSize == next->first)
+		{
+			rangeSize += next->second;
+			freeRanges.erase(next);
+		}
+
+		freeRanges[offset] = rangeSize;
+		usedBytes -= freedBytes;
+		allocationCount--;
+	}
+
+public:
+	vk::DeviceMemory memory;
+	uint32_t memoryType;
+	vk::DeviceSize size;
+	vk::MemoryPropertyFlags properties;
+	bool dedicated;
+	bool optimalTiling;
+
+	std::map<vk::DeviceSize, vk::DeviceSize> freeRanges;
+	vk::DeviceSize usedBytes = 0;
+	uint32_t allocationCount = 0;
+
+	void* mapped = nullptr;
+	uint32_t mapCount = 0;
+};
+
+VulkanMemoryAllocator::VulkanMemoryAllocator(vk::Device device, vk::PhysicalDevice physicalDevice, vk::DeviceSize blockSize)
+	:m_Device(device), m_BlockSize(blockSize)
+{
+	auto limits = physicalDevice.getProperties().limits;
+
+	m_MemoryProps = physicalDevice.getMemoryProperties();
+	m_NonCoherentAtomSize = limits.nonCoherentAtomSize;
+	m_MaxAllocationCount = limits.maxMemoryAllocationCount;
+	m_BufferImageGranularity = limits.bufferImageGranularity;
+	m_Blocks.resize(m_MemoryProps.memoryTypeCount);
+}
+
+VulkanMemoryAllocator::~VulkanMemoryAllocator()
+{
+	for (auto& blocks : m_Blocks)
+	{
+		for (auto block : blocks)
+		{
+			if (block->allocationCount)
+				LOG_WARN("Memory block of type %u destroyed with %u live allocations", block->memoryType, block->allocationCount);
+			destroyBlock(block);
+		}
+	}
+}
+
+VulkanAllocation VulkanMemoryAllocator::Allocate(const vk::MemoryRequirements& reqs, const MemoryPreferences& preferences, bool optimalTiling)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	uint32_t memoryType = findMemoryType(reqs.memoryTypeBits, preferences);
+	vk::DeviceSize blockSize = getBlockSize(memoryType);
+	vk::DeviceSize offset = 0;
+
+	VulkanMemoryBlock* block = nullptr;
+	if (reqs.size > blockSize / 2)
+	{
+		block = createBlock(memoryType, reqs.size, true, optimalTiling);
+		block->allocate(reqs.size, reqs.alignment, offset);
+	}
+	else
+	{
+		// With a granularity of 1 the distinction does not matter and blocks are shared
+		const bool anyBlock = m_BufferImageGranularity <= 1;
+
+		for (auto b : m_Blocks[memoryType])
+		{
+			if (!b->dedicated && (anyBlock || b->optimalTiling == optimalTiling) && b->allocate(reqs.size, reqs.alignment, offset))
+			{
+				block = b;
+				break;
+			}
+		}
+		if (!block)
+		{
+			block = createBlock(memoryType, blockSize, false, optimalTiling);
+			block->allocate(reqs.size, reqs.alignment, offset);
+		}
+	}
+
+	return { block->memory, offset, reqs.size, block->properties, block };
+}
+
+void VulkanMemoryAllocator::Free(VulkanAllocation& allocation)
+{
+	if (!allocation) return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	VulkanMemoryBlock* block = allocation.block;
+	block->free(allocation.offset, allocation.size);
+
+	// Keep one empty block around per memory type so that a create/destroy pattern does not hit the driver every time
+	if (block->allocationCount == 0)
+	{
+		auto& blocks = m_Blocks[block->memoryType];
+		bool keep = !block->dedicated && std::count_if(blocks.begin(), blocks.end(), [](VulkanMemoryBlock* b) { return !b->dedicated && b->allocationCount == 0; }) == 1;
+
+		if (!keep)
+		{
+			blocks.erase(std::find(blocks.begin(), blocks.end(), block));
+			destroyBlock(block);
+		}
+	}
+
+	allocation = {};
+}
+
+void* VulkanMemoryAllocator::Map(const VulkanAllocation& allocation)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	VulkanMemoryBlock* block = allocation.block;
+	ASSERT(block->properties & vk::MemoryPropertyFlagBits::eHostVisible, "Mapping a memory that is not host visible");
+
+	if (block->mapCount++ == 0)
+		block->mapped = m_Device.mapMemory(block->memory, 0, VK_WHOLE_SIZE, {});
+
+	return (char*)block->mapped + allocation.offset;
+}
+
+void VulkanMemoryAllocator::UnMap(const VulkanAllocation& allocation)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	VulkanMemoryBlock* block = allocation.block;
+	ASSERT(block->mapCount, "Unmapping a memory that is not mapped");
+
+	if (--block->mapCount == 0)
+	{
+		m_Device.unmapMemory(block->memory);
+		block->mapped = nullptr;
+	}
+}
+
+void VulkanMemoryAllocator::Flush(const VulkanAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size)
+{
+	m_Device.flushMappedMemoryRanges(getAlignedRange(allocation, offset, size));
+}
+
+void VulkanMemoryAllocator::Invalidate(const VulkanAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size)
+{
+	m_Device.invalidateMappedMemoryRanges(getAlignedRange(allocation, offset, size));
+}
+
+MemoryStats VulkanMemoryAllocator::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	MemoryStats stats;
+	for (const auto& blocks : m_Blocks)
+	{
+		for (const auto block : blocks)
+		{
+			stats.blockCount++;
+			stats.allocationCount += block->allocationCount;
+			stats.reservedBytes += block->size;
+			stats.usedBytes += block->usedBytes;
+		}
+	}
+	return stats;
+}
+
+uint32_t VulkanMemoryAllocator::findMemoryType(uint32_t choices, const MemoryPreferences& preferences) const
+{
+	auto RateMemory = [&](const vk::MemoryType& mem) -> float
+	{
+		auto countBits = [](uint32_t c)
+		{
+			c = c - ((c >> 1) & 0x55555555);
+			c = (c & 0x33333333) + ((c >> 2) & 0x33333333);
+			return ((c + (c >> 4) & 0xF0F0F0F) * 0x1010101) >> 24;
+		};
+		float s = 0;
+		s += ((mem.propertyFlags & preferences.reqs) == preferences.reqs);
+		s += countBits((uint32_t)(mem.propertyFlags & preferences.prefs)) * s * 0.1f;
+		return s;
+	};
+
+	float bestScore = 0;
+	uint32_t bestIdx = -1;
+
+	for (uint32_t i = 0; i < m_MemoryProps.memoryTypeCount; i++) 	if (choices & Bit(i))
+	{
+		float score = RateMemory(m_MemoryProps.memoryTypes[i]);
+		if (score > bestScore)
+		{
+			bestIdx = i;
+			bestScore = score;
+		}
+	}
+
+	ASSERT(bestScore > 0, "Could not find a suitable memory");
+	return bestIdx;
+}
+
+vk::DeviceSize VulkanMemoryAllocator::getBlockSize(uint32_t memoryType) const
+{
+	// Small heaps (e.g. the host visible part of VRAM) get smaller blocks so one block does not eat the whole heap
+	vk::DeviceSize heapSize = m_MemoryProps.memoryHeaps[m_MemoryProps.memoryTypes[memoryType].heapIndex].size;
+	return std::min(m_BlockSize, AlignUp(heapSize / 8, 1024));
+}
+
+vk::MappedMemoryRange VulkanMemoryAllocator::getAlignedRange(const VulkanAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size) const
+{
+	ASSERT(offset <= allocation.size, "Range offset (%llu) is out of the allocation (%llu)", (unsigned long long)offset, (unsigned long long)allocation.size);
+	size = std::min(size, allocation.size - offset);
+
+	vk::DeviceSize begin = AlignDown(allocation.offset + offset, m_NonCoherentAtomSize);
+	vk::DeviceSize end = std::min(AlignUp(allocation.offset + offset + size, m_NonCoherentAtomSize), allocation.block->size);
+
+	return { allocation.memory, begin, end - begin };
+}
+
+VulkanMemoryBlock* VulkanMemoryAllocator::createBlock(uint32_t memoryType, vk::DeviceSize size, bool dedicated, bool optimalTiling)
+{
+	ASSERT(m_BlockCount < m_MaxAllocationCount, "Reached maxMemoryAllocationCount (%u)", m_MaxAllocationCount);
+
+	auto allocInfo = vk::MemoryAllocateInfo()
+		.setAllocationSize(size)
+		.setMemoryTypeIndex(memoryType);
+
+	vk::DeviceMemory memory = m_Device.allocateMemory(allocInfo);
+
+	auto block = new VulkanMemoryBlock(memory, memoryType, size, m_MemoryProps.memoryTypes[memoryType].propertyFlags, dedicated, optimalTiling);
+	m_Blocks[memoryType].push_back(block);
+	m_BlockCount++;
+
+	return block;
+}
+
+void VulkanMemoryAllocator::destroyBlock(VulkanMemoryBlock* block)
+{
+	if (block->mapCount)
+		m_Device.unmapMemory(block->memory);
+	m_Device.freeMemory(block->memory);
+	m_BlockCount--;
+
+	delete block;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "abstraction/RenderDevice.h"
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <mutex>
+
+class VulkanMemoryBlock;
+
+struct MemoryPreferences
+{
+	vk::MemoryPropertyFlags reqs = {}, prefs = {};
+};
+
+struct VulkanAllocation
+{
+	vk::DeviceMemory memory = nullptr;
+	vk::DeviceSize offset = 0;
+	vk::DeviceSize size = 0;
+	vk::MemoryPropertyFlags properties = {};
+	VulkanMemoryBlock* block = nullptr;
+
+	inline operator bool() const { return block != nullptr; }
+};
+
+inline static MemoryPreferences GetVkMemoryFlags(ResourceAccessibilityBits cpuAccessibility, ResourceAccessRate gpuAccessRate)
+{
+	vk::MemoryPropertyFlags req = {}, pref = {};
+
+	switch (gpuAccessRate)
+	{
+	case ResourceAccessRate::Rare:		
+		break;
+	case ResourceAccessRate::Frequent:	
+		pref |= vk::MemoryPropertyFlagBits::eDeviceLocal;
+		break;
+	default:
+		ASSERT(false, "Unknown gpuAccessRate (value = %u)",gpuAccessRate)
+		break;
+	}
+
+	if (cpuAccessibility & ResourceAccessibilityBits::Read)
+	{
+		req |= vk::MemoryPropertyFlagBits::eHostVisible;
+		pref |= vk::MemoryPropertyFlagBits::eHostCached;
+	}
+	if (cpuAccessibility & ResourceAccessibilityBits::Write)
+	{
+		req |= vk::MemoryPropertyFlagBits::eHostVisible;
+	}
+	if (cpuAccessibility & (ResourceAccessibilityBits::Read | ResourceAccessibilityBits::Write))
+	{
+		pref |= vk::MemoryPropertyFlagBits::eHostCoherent;
+	}
+
+	return { req , pref };
+}
+
+/*
+	Hands out sub-ranges of a few large vk::DeviceMemory blocks (one list of blocks per memory type)
+	instead of calling vkAllocateMemory for every resource.
+	Resources bigger than half a block get a dedicated block of their own.
+	Linear resources (buffers, linear images) and optimal images never share a block so that
+	bufferImageGranularity never has to be accounted for between neighbours.
+*/
+class VulkanMemoryAllocator
+{
+public:
+	static constexpr vk::DeviceSize DefaultBlockSize = 64ull * 1024 * 1024;
+
+	VulkanMemoryAllocator(vk::Device device, vk::PhysicalDevice physicalDevice, vk::DeviceSize blockSize = DefaultBlockSize);
+	~VulkanMemoryAllocator();
+
+	VulkanAllocation Allocate(const vk::MemoryRequirements& reqs, const MemoryPreferences& preferences, bool optimalTiling = false);
+	void Free(VulkanAllocation& allocation);
+
+	void* Map(const VulkanAllocation& allocation);
+	void UnMap(const VulkanAllocation& allocation);
+	// offset and size are relative to the allocation, the range is widened to nonCoherentAtomSize
+	void Flush(const VulkanAllocation& allocation, vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE);
+	void Invalidate(const VulkanAllocation& allocation, vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE);
+
+	MemoryStats GetStats() const;
+private:
+	uint32_t findMemoryType(uint32_t choices, const MemoryPreferences& preferences) const;
+	vk::DeviceSize getBlockSize(uint32_t memoryType) const;
+	vk::MappedMemoryRange getAlignedRange(const VulkanAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size) const;
+	VulkanMemoryBlock* createBlock(uint32_t memoryType, vk::DeviceSize size, bool dedicated, bool optimalTiling);
+	void destroyBlock(VulkanMemoryBlock* block);
+
+private:
+	vk::Device m_Device;
+	vk::PhysicalDeviceMemoryProperties m_MemoryProps;
+	vk::DeviceSize m_BlockSize;
+	vk::DeviceSize m_NonCoherentAtomSize;
+	uint32_t m_MaxAllocationCount;
+	vk::DeviceSize m_BufferImageGranularity;
+
+	std::vector<std::vector<VulkanMemoryBlock*>> m_Blocks;
+	uint32_t m_BlockCount = 0;
+
+	mutable std::mutex m_Mutex;
+};
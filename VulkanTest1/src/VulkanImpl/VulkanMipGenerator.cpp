@@ -0,0 +1,270 @@
+#include "pch.h"
+#include "VulkanMipGenerator.h"
+#include "VulkanUploader.h"
+
+static constexpr const char* MipmapShaderPath = "res/shaders/spir-v/mipmap.comp.spv";
+static constexpr uint32_t MipmapGroupSize = 8;
+
+VulkanMipGenerator::VulkanMipGenerator(VulkanRenderDevice* device, bool canBlit)
+	:m_Device(device->getDevice()), m_PhysicalDevice(device->getPhysicalDevice()), m_CanBlit(canBlit)
+{
+	m_CanWriteWithoutFormat = device->getFeatures().shaderStorageImageWriteWithoutFormat;
+
+	if (m_CanWriteWithoutFormat)
+		createComputePipeline(device->getPipelineCache());
+}
+
+VulkanMipGenerator::~VulkanMipGenerator()
+{
+	if (m_ComputePipeline)
+		m_Device.destroyPipeline(m_ComputePipeline);
+	if (m_PipelineLayout)
+		m_Device.destroyPipelineLayout(m_PipelineLayout);
+	if (m_SetLayout)
+		m_Device.destroyDescriptorSetLayout(m_SetLayout);
+	if (m_Sampler)
+		m_Device.destroySampler(m_Sampler);
+}
+
+VulkanMipGenerator::Method VulkanMipGenerator::GetMethod(vk::Format format) const
+{
+	vk::FormatFeatureFlags features = m_PhysicalDevice.getFormatProperties(format).optimalTilingFeatures;
+
+	constexpr vk::FormatFeatureFlags blitFeatures = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+	constexpr vk::FormatFeatureFlags computeFeatures = vk::FormatFeatureFlagBits::eSampledImage | vk::FormatFeatureFlagBits::eStorageImage;
+
+	if (m_CanBlit && (features & blitFeatures) == blitFeatures)
+		return Method::Blit;
+	if (m_ComputePipeline && (features & computeFeatures) == computeFeatures)
+		return Method::Compute;
+	return Method::None;
+}
+
+vk::ImageUsageFlags VulkanMipGenerator::GetRequiredUsage(vk::Format format) const
+{
+	switch (GetMethod(format))
+	{
+	case Method::Blit:		return vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+	case Method::Compute:	return vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage;
+	default:				return {};
+	}
+}
+
+MipChainResources VulkanMipGenerator::Record(vk::CommandBuffer cmd, const VulkanImageUpload& image)
+{
+	switch (GetMethod(image.format))
+	{
+	case Method::Blit:
+		recordBlits(cmd, image);
+		return {};
+	case Method::Compute:
+		return recordCompute(cmd, image);
+	default:
+		ASSERT(false, "Mip generation is not supported for format %s", vk::to_string(image.format).c_str());
+		return {};
+	}
+}
+
+void VulkanMipGenerator::Destroy(MipChainResources& resources)
+{
+	for (auto view : resources.views)
+		m_Device.destroyImageView(view);
+	if (resources.descriptorPool)
+		m_Device.destroyDescriptorPool(resources.descriptorPool);
+
+	resources = {};
+}
+
+uint32_t VulkanMipGenerator::GetMipLevelCount(uint32_t width, uint32_t height)
+{
+	uint32_t levels = 1;
+	for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+		levels++;
+	return levels;
+}
+
+void VulkanMipGenerator::recordBlits(vk::CommandBuffer cmd, const VulkanImageUpload& image)
+{
+	auto barrier = vk::ImageMemoryBarrier()
+		.setImage(image.image)
+		.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+		.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+
+	int32_t width = image.extent.width, height = image.extent.height;
+
+	// Each level is read once it is written : it goes to eTransferSrcOptimal right before being blitted into the next one
+	for (uint32_t level = 1; level < image.mipLevels; level++)
+	{
+		barrier
+			.setSubresourceRange({ vk::ImageAspectFlagBits::eColor,level - 1,1,0,1 })
+			.setOldLayout(vk::ImageLayout::eTransferDstOptimal).setNewLayout(vk::ImageLayout::eTransferSrcOptimal)
+			.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite).setDstAccessMask(vk::AccessFlagBits::eTransferRead);
+
+		cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, barrier);
+
+		int32_t nextWidth = std::max(width / 2, 1), nextHeight = std::max(height / 2, 1);
+
+		auto blit = vk::ImageBlit()
+			.setSrcSubresource({ vk::ImageAspectFlagBits::eColor,level - 1,0,1 })
+			.setSrcOffsets({ vk::Offset3D{ 0,0,0 },vk::Offset3D{ width,height,1 } })
+			.setDstSubresource({ vk::ImageAspectFlagBits::eColor,level,0,1 })
+			.setDstOffsets({ vk::Offset3D{ 0,0,0 },vk::Offset3D{ nextWidth,nextHeight,1 } });
+
+		cmd.blitImage(image.image, vk::ImageLayout::eTransferSrcOptimal, image.image, vk::ImageLayout::eTransferDstOptimal, blit, vk::Filter::eLinear);
+
+		width = nextWidth;
+		height = nextHeight;
+	}
+
+	std::array<vk::ImageMemoryBarrier, 2> finalBarriers =
+	{
+		vk::ImageMemoryBarrier(barrier)
+			.setSubresourceRange({ vk::ImageAspectFlagBits::eColor,0,image.mipLevels - 1,0,1 })
+			.setOldLayout(vk::ImageLayout::eTransferSrcOptimal).setNewLayout(image.finalLayout)
+			.setSrcAccessMask(vk::AccessFlagBits::eTransferRead).setDstAccessMask(image.dstAccess),
+		vk::ImageMemoryBarrier(barrier)
+			.setSubresourceRange({ vk::ImageAspectFlagBits::eColor,image.mipLevels - 1,1,0,1 })
+			.setOldLayout(vk::ImageLayout::eTransferDstOptimal).setNewLayout(image.finalLayout)
+			.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite).setDstAccessMask(image.dstAccess),
+	};
+
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, image.dstStages, {}, nullptr, nullptr, finalBarriers);
+}
+
+MipChainResources VulkanMipGenerator::recordCompute(vk::CommandBuffer cmd, const VulkanImageUpload& image)
+{
+	MipChainResources resources;
+
+	const uint32_t passes = image.mipLevels - 1;
+
+	std::array<vk::DescriptorPoolSize, 2> poolSizes =
+	{
+		vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, passes),
+		vk::DescriptorPoolSize(vk::DescriptorType::eStorageImage, passes),
+	};
+	resources.descriptorPool = m_Device.createDescriptorPool(vk::DescriptorPoolCreateInfo()
+		.setMaxSets(passes)
+		.setPoolSizeCount(poolSizes.size()).setPPoolSizes(poolSizes.data()));
+
+	std::vector<vk::DescriptorSetLayout> layouts(passes, m_SetLayout);
+	auto sets = m_Device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo()
+		.setDescriptorPool(resources.descriptorPool)
+		.setDescriptorSetCount(passes).setPSetLayouts(layouts.data()));
+
+	resources.views.resize(image.mipLevels);
+	for (uint32_t level = 0; level < image.mipLevels; level++)
+	{
+		resources.views[level] = m_Device.createImageView(vk::ImageViewCreateInfo()
+			.setImage(image.image)
+			.setViewType(vk::ImageViewType::e2D)
+			.setFormat(image.format)
+			.setSubresourceRange({ vk::ImageAspectFlagBits::eColor,level,1,0,1 }));
+	}
+
+	// Source and destination level share eGeneral, so no layout change is needed between passes
+	auto barrier = vk::ImageMemoryBarrier()
+		.setImage(image.image)
+		.setSubresourceRange({ vk::ImageAspectFlagBits::eColor,0,image.mipLevels,0,1 })
+		.setOldLayout(vk::ImageLayout::eTransferDstOptimal).setNewLayout(vk::ImageLayout::eGeneral)
+		.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite).setDstAccessMask(vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite)
+		.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+		.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, barrier);
+	cmd.bindPipeline(vk::PipelineBindPoint::eCompute, m_ComputePipeline);
+
+	uint32_t width = image.extent.width, height = image.extent.height;
+	for (uint32_t level = 1; level < image.mipLevels; level++)
+	{
+		width = std::max(width / 2, 1u);
+		height = std::max(height / 2, 1u);
+
+		auto srcInfo = vk::DescriptorImageInfo(m_Sampler, resources.views[level - 1], vk::ImageLayout::eGeneral);
+		auto dstInfo = vk::DescriptorImageInfo(nullptr, resources.views[level], vk::ImageLayout::eGeneral);
+
+		std::array<vk::WriteDescriptorSet, 2> writes =
+		{
+			vk::WriteDescriptorSet()
+				.setDstSet(sets[level - 1]).setDstBinding(0)
+				.setDescriptorCount(1).setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+				.setPImageInfo(&srcInfo),
+			vk::WriteDescriptorSet()
+				.setDstSet(sets[level - 1]).setDstBinding(1)
+				.setDescriptorCount(1).setDescriptorType(vk::DescriptorType::eStorageImage)
+				.setPImageInfo(&dstInfo),
+		};
+		m_Device.updateDescriptorSets(writes, nullptr);
+
+		cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_PipelineLayout, 0, sets[level - 1], {});
+		cmd.dispatch((width + MipmapGroupSize - 1) / MipmapGroupSize, (height + MipmapGroupSize - 1) / MipmapGroupSize, 1);
+
+		barrier
+			.setSubresourceRange({ vk::ImageAspectFlagBits::eColor,level,1,0,1 })
+			.setOldLayout(vk::ImageLayout::eGeneral).setNewLayout(vk::ImageLayout::eGeneral)
+			.setSrcAccessMask(vk::AccessFlagBits::eShaderWrite).setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+
+		cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, barrier);
+	}
+
+	barrier
+		.setSubresourceRange({ vk::ImageAspectFlagBits::eColor,0,image.mipLevels,0,1 })
+		.setOldLayout(vk::ImageLayout::eGeneral).setNewLayout(image.finalLayout)
+		.setSrcAccessMask(vk::AccessFlagBits::eShaderWrite).setDstAccessMask(image.dstAccess);
+
+	cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, image.dstStages, {}, nullptr, nullptr, barrier);
+
+	return resources;
+}
+
+void VulkanMipGenerator::createComputePipeline(vk::PipelineCache cache)
+{
+	std::ifstream file(MipmapShaderPath, std::ios::ate | std::ios::binary);
+	if (!file)
+	{
+		LOG_WARN("Could not find \"%s\", mips of formats that cannot be blitted will not be generated", MipmapShaderPath);
+		return;
+	}
+
+	std::vector<char> code(file.tellg());
+	file.seekg(0);
+	file.read(code.data(), code.size());
+
+	m_Sampler = m_Device.createSampler(vk::SamplerCreateInfo()
+		.setMagFilter(vk::Filter::eNearest).setMinFilter(vk::Filter::eNearest)
+		.setMipmapMode(vk::SamplerMipmapMode::eNearest)
+		.setAddressModeU(vk::SamplerAddressMode::eClampToEdge).setAddressModeV(vk::SamplerAddressMode::eClampToEdge).setAddressModeW(vk::SamplerAddressMode::eClampToEdge)
+		.setMinLod(0).setMaxLod(0));
+
+	std::array<vk::DescriptorSetLayoutBinding, 2> bindings =
+	{
+		vk::DescriptorSetLayoutBinding()
+			.setBinding(0)
+			.setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+			.setDescriptorCount(1)
+			.setStageFlags(vk::ShaderStageFlagBits::eCompute),
+		vk::DescriptorSetLayoutBinding()
+			.setBinding(1)
+			.setDescriptorType(vk::DescriptorType::eStorageImage)
+			.setDescriptorCount(1)
+			.setStageFlags(vk::ShaderStageFlagBits::eCompute),
+	};
+	m_SetLayout = m_Device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo()
+		.setBindingCount(bindings.size()).setPBindings(bindings.data()));
+
+	m_PipelineLayout = m_Device.createPipelineLayout(vk::PipelineLayoutCreateInfo()
+		.setSetLayoutCount(1).setPSetLayouts(&m_SetLayout));
+
+	vk::ShaderModule module = m_Device.createShaderModule(vk::ShaderModuleCreateInfo()
+		.setCodeSize(code.size()).setPCode((uint32_t*)code.data()));
+
+	auto pipelineInfo = vk::ComputePipelineCreateInfo()
+		.setLayout(m_PipelineLayout)
+		.setStage(vk::PipelineShaderStageCreateInfo()
+			.setStage(vk::ShaderStageFlagBits::eCompute)
+			.setModule(module)
+			.setPName("main"));
+
+	m_ComputePipeline = m_Device.createComputePipeline(cache, pipelineInfo).value;
+
+	m_Device.destroyShaderModule(module);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "VulkanImpl/VulkanRenderDevice.h"
+#include <vulkan/vulkan.hpp>
+#include <vector>
+
+struct VulkanImageUpload;
+
+// Per image objects of the compute path, they must outlive the command buffer the chain was recorded in
+struct MipChainResources
+{
+	vk::DescriptorPool descriptorPool;
+	std::vector<vk::ImageView> views;
+};
+
+/*
+	Fills the mip levels of an image from its first level.
+	Formats that support linear blits go through a chain of vkCmdBlitImage (graphics queues only),
+	the others are downsampled by a compute shader (res/shaders/spir-v/mipmap.comp.spv) with a 2x2 box filter.
+*/
+class VulkanMipGenerator
+{
+public:
+	enum class Method
+	{
+		None, Blit, Compute
+	};
+
+	VulkanMipGenerator(VulkanRenderDevice* device, bool canBlit);
+	~VulkanMipGenerator();
+
+	Method GetMethod(vk::Format format) const;
+	// Usage flags an image of this format needs for its mips to be generated
+	vk::ImageUsageFlags GetRequiredUsage(vk::Format format) const;
+
+	// Expects every level in eTransferDstOptimal with the first one written by a transfer,
+	// leaves every level in image.finalLayout
+	MipChainResources Record(vk::CommandBuffer cmd, const VulkanImageUpload& image);
+	void Destroy(MipChainResources& resources);
+
+	static uint32_t GetMipLevelCount(uint32_t width, uint32_t height);
+private:
+	void recordBlits(vk::CommandBuffer cmd, const VulkanImageUpload& image);
+	MipChainResources recordCompute(vk::CommandBuffer cmd, const VulkanImageUpload& image);
+	void createComputePipeline(vk::PipelineCache cache);
+
+private:
+	vk::Device m_Device;
+	vk::PhysicalDevice m_PhysicalDevice;
+	bool m_CanBlit;
+	bool m_CanWriteWithoutFormat;
+
+	vk::Sampler m_Sampler;
+	vk::DescriptorSetLayout m_SetLayout;
+	vk::PipelineLayout m_PipelineLayout;
+	vk::Pipeline m_ComputePipeline;
+};
@@ -0,0 +1,124 @@
+#include "pch.h"
+#include "VulkanOffscreenSwapchain.h"
+#include "VulkanImpl/VulkanImage.h"
+#include "VulkanImpl/VulkanImageView.h"
+#include "VulkanImpl/VulkanReceipe.h"
+
+VulkanOffscreenSwapchain::VulkanOffscreenSwapchain(vk::Device device, const VulkanOffscreenSwapchainDesc& desc)
+	:m_Device(device), m_Desc(desc)
+{
+	ASSERT(desc.allocator, "The offscreen swapchain needs an allocator for its images");
+
+	create(desc.imagesDimensions);
+}
+
+VulkanOffscreenSwapchain::~VulkanOffscreenSwapchain()
+{
+	for (auto& retired : m_Retired)
+		destroy(retired);
+	destroy({ std::move(m_Images), std::move(m_Views), 0 });
+}
+
+SwapchainImage VulkanOffscreenSwapchain::GetNextImage(Receipe* receipe)
+{
+	collectRetired();
+
+	// Nothing to wait for, the previous uses of the image are ordered before the new frame on the same queue
+	m_CurrentIndex = (m_CurrentIndex + 1) % m_Images.size();
+	if (receipe)
+	{
+		vk::Semaphore signal = static_cast<VulkanReceipe*>(receipe)->getVkSemaphore();
+		m_Desc.queue.submit(vk::SubmitInfo().setSignalSemaphoreCount(1).setPSignalSemaphores(&signal), nullptr);
+	}
+
+	m_AcquireCount++;
+
+	return { m_Views[m_CurrentIndex],m_CurrentIndex };
+}
+
+void VulkanOffscreenSwapchain::Present(ArrayProxy<Receipe*> receipes)
+{
+	// The semaphores still have to be waited on to be signaled again by the next frame
+	std::vector<vk::Semaphore> semaphores(receipes.size());
+	std::vector<vk::PipelineStageFlags> stages(receipes.size(), vk::PipelineStageFlagBits::eAllCommands);
+	uint32_t i = 0;
+	for (const auto& receipe : receipes)
+		semaphores[i++] = static_cast<VulkanReceipe*>(receipe)->getVkSemaphore();
+
+	if (semaphores.size())
+	{
+		auto submitInfo = vk::SubmitInfo()
+			.setWaitSemaphoreCount(semaphores.size()).setPWaitSemaphores(semaphores.data())
+			.setPWaitDstStageMask(stages.data());
+		m_Desc.queue.submit(submitInfo, nullptr);
+	}
+}
+
+void VulkanOffscreenSwapchain::ReSize(Dimensions2Du dimensions)
+{
+	if (dimensions.width == 0 || dimensions.height == 0)
+		return;
+
+	// Same delay as the real swapchain : the frames that used the old images are done once as many images were acquired
+	uint64_t retireDelay = std::max<uint64_t>(m_Desc.framesInFlight, m_Images.size());
+	m_Retired.push_back({ std::move(m_Images), std::move(m_Views), m_AcquireCount + retireDelay });
+
+	create(dimensions);
+	m_Generation++;
+}
+
+void VulkanOffscreenSwapchain::create(Dimensions2Du dimensions)
+{
+	m_ImagesDesc = {};
+	m_ImagesDesc.format = m_Desc.format;
+	m_ImagesDesc.dimensions = { dimensions.width,dimensions.height,1 };
+	m_ImagesDesc.type = ImageType::e2D;
+	m_ImagesDesc.layers = 1;
+	m_ImagesDesc.usage = ImageUsageBits::ColorAttachment | ImageUsageBits::TransferSrc;
+
+	// One more image than frames in flight, like a fifo swapchain with minImageCount + 1
+	const uint32_t imageCount = m_Desc.framesInFlight + 1;
+	m_Images.resize(imageCount);
+	m_Views.resize(imageCount);
+	m_CurrentIndex = UINT32_MAX;
+
+	VulkanImageDesc imageDesc;
+	static_cast<ImageDesc&>(imageDesc) = m_ImagesDesc;
+	imageDesc.queueFamilies = { m_Desc.queueFamily };
+	imageDesc.allocator = m_Desc.allocator;
+
+	VulkanImageViewDesc viewDesc;
+	{
+		viewDesc.baseLayer = 0;
+		viewDesc.layers = 1;
+		viewDesc.dimensions = m_ImagesDesc.dimensions;
+		viewDesc.type = ImageViewType::e2D;
+		viewDesc.aspect = ImageViewAspect::Color;
+	}
+
+	for (uint32_t i = 0; i < imageCount; i++)
+	{
+		m_Images[i] = new VulkanImage(m_Device, imageDesc);
+
+		viewDesc.image = m_Images[i];
+		m_Views[i] = new VulkanImageView(m_Device, viewDesc);
+	}
+}
+
+void VulkanOffscreenSwapchain::collectRetired()
+{
+	auto it = std::remove_if(m_Retired.begin(), m_Retired.end(), [&](Retired& retired)
+		{
+			if (retired.destroyAt > m_AcquireCount)
+				return false;
+			destroy(retired);
+			return true;
+		});
+	m_Retired.erase(it, m_Retired.end());
+}
+
+void VulkanOffscreenSwapchain::destroy(const Retired& retired)
+{
+	for (auto& view : retired.views) delete view;
+	for (auto& image : retired.images) delete image;
+}
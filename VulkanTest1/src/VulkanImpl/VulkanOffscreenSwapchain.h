@@ -0,0 +1,65 @@
+#pragma once
+
+#include "abstraction/Swapchain.h"
+#include "VulkanImpl/VulkanMemoryAllocator.h"
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <set>
+
+struct VulkanOffscreenSwapchainDesc : public SwapchainDesc
+{
+	ImageFormat format = ImageFormat::RGBA8;
+	uint32_t queueFamily;
+	// The empty submissions standing in for acquiring and presenting with receipes go to this queue
+	vk::Queue queue;
+	VulkanMemoryAllocator* allocator = nullptr;
+	uint32_t framesInFlight = 2;
+};
+
+/*
+	Swapchain without a surface : a ring of device local images handed out in order, for headless runs.
+	The images are handed out in submission order on a single queue, so the frame loop doesn't need receipes and
+	nothing is submitted when none are given. With receipes, acquiring signals the semaphore right away and presenting
+	only waits on them, each with an empty submission. The images end up with eTransferSrc usage so they can be read back.
+*/
+class VulkanOffscreenSwapchain : public Swapchain
+{
+public:
+	VulkanOffscreenSwapchain(vk::Device device, const VulkanOffscreenSwapchainDesc& desc);
+	~VulkanOffscreenSwapchain();
+
+	virtual SwapchainImage GetNextImage(Receipe* receipe = nullptr) override;
+	virtual void Present(ArrayProxy<Receipe*> receipes) override;
+	virtual void ReSize(Dimensions2Du dimensions) override;
+
+	inline virtual bool IsOutOfDate() const override { return false; }
+	inline virtual uint32_t GetGeneration() const override { return m_Generation; }
+
+	inline virtual const ImageDesc& GetImagesDesc() const override { return m_ImagesDesc; };
+	inline virtual uint32_t GetImageCount() const override { return m_Images.size(); }
+	inline virtual ImageView* GetImageView(uint32_t i) override { return m_Views[i]; }
+private:
+	struct Retired
+	{
+		std::vector<Image*> images;
+		std::vector<ImageView*> views;
+		uint64_t destroyAt;
+	};
+
+	void create(Dimensions2Du dimensions);
+	void collectRetired();
+	void destroy(const Retired& retired);
+private:
+	vk::Device m_Device;
+	VulkanOffscreenSwapchainDesc m_Desc;
+
+	std::vector<Image*> m_Images;
+	std::vector<ImageView*> m_Views;
+	ImageDesc m_ImagesDesc;
+
+	uint32_t m_CurrentIndex = UINT32_MAX;
+
+	std::vector<Retired> m_Retired;
+	uint64_t m_AcquireCount = 0;
+	uint32_t m_Generation = 0;
+};
@@ -0,0 +1,77 @@
+#include "pch.h"
+#include "VulkanParallelRecorder.h"
+#include "Tracing.h"
+
+VulkanParallelRecorder::VulkanParallelRecorder(vk::Device device, uint32_t queueFamily, uint32_t framesInFlight, ThreadPool* threadPool)
+	:m_Device(device), m_ThreadPool(threadPool)
+{
+	auto poolInfo = vk::CommandPoolCreateInfo().setQueueFamilyIndex(queueFamily)
+		.setFlags(vk::CommandPoolCreateFlagBits::eTransient);
+
+	m_Frames.resize(framesInFlight);
+	for (auto& frame : m_Frames)
+	{
+		frame.resize(threadPool->GetThreadCount());
+		for (auto& threadFrame : frame)
+			threadFrame.pool = m_Device.createCommandPool(poolInfo);
+	}
+}
+
+VulkanParallelRecorder::~VulkanParallelRecorder()
+{
+	for (auto& frame : m_Frames)
+		for (auto& threadFrame : frame)
+			m_Device.destroyCommandPool(threadFrame.pool);
+}
+
+void VulkanParallelRecorder::BeginFrame(uint32_t frameIndex)
+{
+	ASSERT(frameIndex < m_Frames.size(), "Frame index %u is out of range (%u frames)", frameIndex, (uint32_t)m_Frames.size());
+
+	m_CurrentFrame = frameIndex;
+	for (auto& threadFrame : m_Frames[frameIndex])
+	{
+		m_Device.resetCommandPool(threadFrame.pool, {});
+		threadFrame.used = 0;
+	}
+}
+
+std::vector<vk::CommandBuffer> VulkanParallelRecorder::Record(uint32_t chunkCount, const vk::CommandBufferInheritanceInfo& inheritance, const RecordFunction& record)
+{
+	std::vector<vk::CommandBuffer> buffers(chunkCount);
+	std::vector<ThreadFrame>& frame = m_Frames[m_CurrentFrame];
+
+	m_ThreadPool->ParallelFor(chunkCount, [&](uint32_t chunk, uint32_t threadIndex)
+		{
+			TRACE_ZONE("Record chunk");
+
+			// Only this worker touches its pool, no locking needed
+			vk::CommandBuffer commandBuffer = getBuffer(frame[threadIndex]);
+
+			auto beginInfo = vk::CommandBufferBeginInfo()
+				.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit | (inheritance.renderPass ? vk::CommandBufferUsageFlagBits::eRenderPassContinue : vk::CommandBufferUsageFlags()))
+				.setPInheritanceInfo(&inheritance);
+
+			commandBuffer.begin(beginInfo);
+			record(commandBuffer, chunk);
+			commandBuffer.end();
+
+			buffers[chunk] = commandBuffer;
+		});
+
+	return buffers;
+}
+
+vk::CommandBuffer VulkanParallelRecorder::getBuffer(ThreadFrame& threadFrame)
+{
+	if (threadFrame.used == threadFrame.buffers.size())
+	{
+		threadFrame.buffers.push_back(m_Device.allocateCommandBuffers(vk::CommandBufferAllocateInfo()
+			.setCommandPool(threadFrame.pool)
+			.setCommandBufferCount(1)
+			.setLevel(vk::CommandBufferLevel::eSecondary)
+		)[0]);
+	}
+
+	return threadFrame.buffers[threadFrame.used++];
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <functional>
+
+/*
+	Records secondary command buffers on the workers of a ThreadPool.
+	Every worker owns one command pool per frame in flight, the pools of a frame are reset as a whole
+	in BeginFrame (the frame must be done on the gpu) instead of freeing individual buffers.
+	The returned buffers are meant to be stitched into a primary one with executeCommands.
+*/
+class VulkanParallelRecorder
+{
+public:
+	using RecordFunction = std::function<void(vk::CommandBuffer commandBuffer, uint32_t chunk)>;
+
+	VulkanParallelRecorder(vk::Device device, uint32_t queueFamily, uint32_t framesInFlight, ThreadPool* threadPool);
+	~VulkanParallelRecorder();
+
+	void BeginFrame(uint32_t frameIndex);
+	// Records chunkCount secondary buffers in parallel, returned in chunk order
+	std::vector<vk::CommandBuffer> Record(uint32_t chunkCount, const vk::CommandBufferInheritanceInfo& inheritance, const RecordFunction& record);
+
+	inline uint32_t GetThreadCount() const { return m_ThreadPool->GetThreadCount(); }
+private:
+	struct ThreadFrame
+	{
+		vk::CommandPool pool;
+		std::vector<vk::CommandBuffer> buffers;
+		uint32_t used = 0;
+	};
+
+	vk::CommandBuffer getBuffer(ThreadFrame& threadFrame);
+private:
+	vk::Device m_Device;
+	ThreadPool* m_ThreadPool;
+
+	// [frame][thread]
+	std::vector<std::vector<ThreadFrame>> m_Frames;
+	uint32_t m_CurrentFrame = 0;
+};
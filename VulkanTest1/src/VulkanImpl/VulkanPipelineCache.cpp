@@ -0,0 +1,110 @@
+#include "pch.h"
+#include "VulkanPipelineCache.h"
+#include "Utils.h"
+
+// Prepended to the driver's data : the driver is not required to validate what it is given
+struct PipelineCacheFileHeader
+{
+	uint32_t magic;
+	uint32_t dataSize;
+	uint64_t checksum;
+};
+
+static constexpr uint32_t PipelineCacheMagic = 0x43504B56; // "VKPC"
+
+VulkanPipelineCache::VulkanPipelineCache(vk::Device device, const vk::PhysicalDeviceProperties& properties, const std::string& directory)
+	:m_Device(device), m_Properties(properties)
+{
+	char name[64];
+	snprintf(name, sizeof(name), "pipelines_%04x_%04x_%08x.cache", properties.vendorID, properties.deviceID, properties.driverVersion);
+	m_Path = (std::filesystem::path(directory) / name).string();
+
+	std::vector<char> data = load();
+
+	auto cacheInfo = vk::PipelineCacheCreateInfo()
+		.setInitialDataSize(data.size()).setPInitialData(data.data());
+
+	m_Cache = m_Device.createPipelineCache(cacheInfo);
+}
+
+VulkanPipelineCache::~VulkanPipelineCache()
+{
+	m_Device.destroyPipelineCache(m_Cache);
+}
+
+bool VulkanPipelineCache::Save()
+{
+	std::vector<uint8_t> data = m_Device.getPipelineCacheData(m_Cache);
+	if (data.empty())
+		return false;
+
+	PipelineCacheFileHeader header = { PipelineCacheMagic, (uint32_t)data.size(), Fnv1a(data.data(), data.size()) };
+
+	std::string error;
+	if (!ReplaceFile(m_Path, { { &header, sizeof(header) }, { data.data(), data.size() } }, error))
+	{
+		LOG_WARN("Failed to save the pipeline cache to \"%s\" : %s", m_Path.c_str(), error.c_str());
+		return false;
+	}
+
+	LOG_INFO("Pipeline cache saved to \"%s\" (%zu bytes)", m_Path.c_str(), data.size());
+	return true;
+}
+
+std::vector<char> VulkanPipelineCache::load()
+{
+	std::ifstream file(m_Path, std::ios::ate | std::ios::binary);
+	if (!file)
+	{
+		LOG_INFO("No pipeline cache at \"%s\", pipelines will be compiled from scratch", m_Path.c_str());
+		return {};
+	}
+
+	std::vector<char> content(file.tellg());
+	file.seekg(0);
+	file.read(content.data(), content.size());
+
+	if (!isValid(content))
+	{
+		LOG_WARN("Pipeline cache \"%s\" is invalid or was made for another device/driver, ignoring it", m_Path.c_str());
+		return {};
+	}
+
+	LOG_INFO("Pipeline cache loaded from \"%s\" (%zu bytes)", m_Path.c_str(), content.size() - sizeof(PipelineCacheFileHeader));
+	return { content.begin() + sizeof(PipelineCacheFileHeader), content.end() };
+}
+
+bool VulkanPipelineCache::isValid(const std::vector<char>& content) const
+{
+	if (content.size() < sizeof(PipelineCacheFileHeader))
+		return false;
+
+	PipelineCacheFileHeader header;
+	memcpy(&header, content.data(), sizeof(header));
+
+	const char* data = content.data() + sizeof(header);
+	const size_t dataSize = content.size() - sizeof(header);
+
+	if (header.magic != PipelineCacheMagic || header.dataSize != dataSize || header.checksum != Fnv1a(data, dataSize))
+		return false;
+
+	// Vulkan's own header (VkPipelineCacheHeaderVersionOne) : size, version, vendor, device, uuid
+	struct
+	{
+		uint32_t headerSize;
+		uint32_t headerVersion;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint8_t uuid[VK_UUID_SIZE];
+	} vkHeader;
+
+	if (dataSize < sizeof(vkHeader))
+		return false;
+	memcpy(&vkHeader, data, sizeof(vkHeader));
+
+	return vkHeader.headerSize >= sizeof(vkHeader)
+		&& vkHeader.headerVersion == (uint32_t)vk::PipelineCacheHeaderVersion::eOne
+		&& vkHeader.vendorID == m_Properties.vendorID
+		&& vkHeader.deviceID == m_Properties.deviceID
+		&& memcmp(vkHeader.uuid, m_Properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
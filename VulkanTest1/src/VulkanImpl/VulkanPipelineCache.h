@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <string>
+
+/*
+	vk::PipelineCache backed by a file, so pipelines compiled by a previous run are not compiled again.
+	The file name is keyed by vendor/device id and driver version, its content is checked against
+	the device (header + pipelineCacheUUID) and a checksum before being handed to the driver.
+	Saving writes a temporary file that replaces the old one only once it is complete.
+*/
+class VulkanPipelineCache
+{
+public:
+	VulkanPipelineCache(vk::Device device, const vk::PhysicalDeviceProperties& properties, const std::string& directory);
+	~VulkanPipelineCache();
+
+	bool Save();
+public:
+	inline vk::PipelineCache getVkPipelineCache() { return m_Cache; }
+	inline const std::string& getPath() const { return m_Path; }
+private:
+	std::vector<char> load();
+	bool isValid(const std::vector<char>& data) const;
+
+private:
+	vk::Device m_Device;
+	vk::PhysicalDeviceProperties m_Properties;
+	vk::PipelineCache m_Cache;
+	std::string m_Path;
+};
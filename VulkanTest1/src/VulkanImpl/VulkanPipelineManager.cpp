@@ -0,0 +1,155 @@
+#include "pch.h"
+#include "VulkanPipelineManager.h"
+#include "Tracing.h"
+
+VulkanPipelineManager::VulkanPipelineManager(VulkanRenderDevice* device, ThreadPool* threadPool)
+	:m_Device(device->getDevice()), m_Cache(device->getPipelineCache()), m_ThreadPool(threadPool)
+{}
+
+VulkanPipelineManager::~VulkanPipelineManager()
+{
+	WaitIdle();
+
+	for (const Entry& entry : m_Entries)
+	{
+		if (entry.pipeline)
+			m_Device.destroyPipeline(entry.pipeline);
+	}
+}
+
+PipelineHandle VulkanPipelineManager::Create(const VulkanGraphicsPipelineDesc& desc, PipelineHandle fallback)
+{
+	ASSERT(desc.program && desc.renderPass, "The pipeline \"%s\" needs a shader program and a render pass", desc.name.c_str());
+
+	PipelineHandle handle;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		ASSERT(fallback == InvalidHandle || fallback < m_Entries.size(), "Invalid fallback pipeline %u", fallback);
+
+		handle = (PipelineHandle)m_Entries.size();
+		m_Entries.push_back({ desc, fallback, nullptr, PipelineStatus::Pending });
+		m_Pending++;
+	}
+
+	m_ThreadPool->Submit([this, handle](uint32_t threadIndex) { compile(handle); });
+	return handle;
+}
+
+void VulkanPipelineManager::Destroy(PipelineHandle handle)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	ASSERT(handle < m_Entries.size(), "Invalid pipeline %u", handle);
+
+	Entry& entry = m_Entries[handle];
+	ASSERT(entry.status != PipelineStatus::Pending, "The pipeline \"%s\" is still compiling", entry.desc.name.c_str());
+
+	if (entry.pipeline)
+		m_Device.destroyPipeline(entry.pipeline);
+	entry.pipeline = nullptr;
+	entry.status = PipelineStatus::Failed;
+}
+
+vk::Pipeline VulkanPipelineManager::Get(PipelineHandle handle) const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	while (handle != InvalidHandle)
+	{
+		ASSERT(handle < m_Entries.size(), "Invalid pipeline %u", handle);
+		const Entry& entry = m_Entries[handle];
+		if (entry.status == PipelineStatus::Ready)
+			return entry.pipeline;
+		handle = entry.fallback;
+	}
+	return nullptr;
+}
+
+PipelineStatus VulkanPipelineManager::GetStatus(PipelineHandle handle) const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	ASSERT(handle < m_Entries.size(), "Invalid pipeline %u", handle);
+
+	return m_Entries[handle].status;
+}
+
+void VulkanPipelineManager::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Idle.wait(lock, [this]() { return m_Pending == 0; });
+}
+
+void VulkanPipelineManager::compile(PipelineHandle handle)
+{
+	TRACE_ZONE("Compile pipeline");
+
+	// A copy, the entries move when pipelines are added
+	VulkanGraphicsPipelineDesc desc;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		desc = m_Entries[handle].desc;
+	}
+	const auto& stages = desc.program->getStages();
+
+	auto inputAssemblyState = vk::PipelineInputAssemblyStateCreateInfo()
+		.setTopology(desc.topology)
+		.setPrimitiveRestartEnable(false);
+
+	auto viewportState = vk::PipelineViewportStateCreateInfo()
+		.setViewportCount(1)
+		.setScissorCount(1);
+
+	std::array<vk::DynamicState, 2> dynamicStates = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+	auto dynamicState = vk::PipelineDynamicStateCreateInfo()
+		.setDynamicStateCount(dynamicStates.size()).setPDynamicStates(dynamicStates.data());
+
+	auto rasterizationState = vk::PipelineRasterizationStateCreateInfo()
+		.setFrontFace(desc.frontFace)
+		.setCullMode(desc.cullMode)
+		.setDepthBiasEnable(false)
+		.setPolygonMode(desc.polygonMode)
+		.setLineWidth(1.0f);
+
+	auto msState = vk::PipelineMultisampleStateCreateInfo()
+		.setSampleShadingEnable(false)
+		.setRasterizationSamples(vk::SampleCountFlagBits::e1);
+
+	auto attachment = vk::PipelineColorBlendAttachmentState()
+		.setBlendEnable(desc.blend)
+		.setSrcColorBlendFactor(vk::BlendFactor::eSrcAlpha).setDstColorBlendFactor(vk::BlendFactor::eOneMinusSrcAlpha).setColorBlendOp(vk::BlendOp::eAdd)
+		.setSrcAlphaBlendFactor(vk::BlendFactor::eOne).setDstAlphaBlendFactor(vk::BlendFactor::eZero).setAlphaBlendOp(vk::BlendOp::eAdd)
+		.setColorWriteMask(vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA);
+	auto blendState = vk::PipelineColorBlendStateCreateInfo()
+		.setAttachmentCount(1).setPAttachments(&attachment)
+		.setLogicOpEnable(false);
+
+	auto pipelineInfo = vk::GraphicsPipelineCreateInfo()
+		.setPInputAssemblyState(&inputAssemblyState)
+		.setPVertexInputState(&desc.program->getVertexInputState())
+		.setPViewportState(&viewportState)
+		.setPRasterizationState(&rasterizationState)
+		.setPMultisampleState(&msState)
+		.setPColorBlendState(&blendState)
+		.setPDynamicState(&dynamicState)
+		.setLayout(desc.program->getPipelineLayout())
+		.setRenderPass(desc.renderPass)
+		.setSubpass(desc.subpass)
+		.setStageCount(stages.size()).setPStages(stages.data());
+
+	// The pointer overload returns the error instead of throwing it on the worker
+	auto start = std::chrono::steady_clock::now();
+	vk::Pipeline pipeline;
+	vk::Result result = m_Device.createGraphicsPipelines(m_Cache, 1, &pipelineInfo, nullptr, &pipeline);
+	if (result == vk::Result::eSuccess)
+		LOG_INFO("Pipeline \"%s\" compiled in %.2f ms", desc.name.c_str(), std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	else
+		LOG_ERROR("Failed to compile the pipeline \"%s\" : %s", desc.name.c_str(), vk::to_string(result).c_str());
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Entry& entry = m_Entries[handle];
+		entry.pipeline = result == vk::Result::eSuccess ? pipeline : vk::Pipeline();
+		entry.status = entry.pipeline ? PipelineStatus::Ready : PipelineStatus::Failed;
+		if (--m_Pending == 0)
+			m_Idle.notify_all();
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "VulkanImpl/VulkanRenderDevice.h"
+#include "VulkanImpl/VulkanShaderProgram.h"
+#include "ThreadPool.h"
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+
+// Index of a pipeline in its manager, never reused
+using PipelineHandle = uint32_t;
+
+enum class PipelineStatus
+{
+	Pending, Ready, Failed
+};
+
+// Viewport and scissor are always dynamic
+struct VulkanGraphicsPipelineDesc
+{
+	std::string name;
+	// Must outlive the compilation
+	const VulkanShaderProgram* program = nullptr;
+	vk::RenderPass renderPass;
+	uint32_t subpass = 0;
+
+	vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+	vk::PolygonMode polygonMode = vk::PolygonMode::eFill;
+	vk::CullModeFlags cullMode = vk::CullModeFlagBits::eNone;
+	vk::FrontFace frontFace = vk::FrontFace::eClockwise;
+	bool blend = false;
+};
+
+/*
+	Compiles graphics pipelines on the workers of a ThreadPool, through the device's pipeline cache.
+	Create() only queues the compilation and hands back a handle at once, Get() returns the pipeline once it is compiled
+	and the pipeline of the fallback (recursively) until then. A null pipeline means nothing usable yet : the draws
+	are skipped for that frame rather than waiting for the driver.
+	The pool should not be the one recording the frames, a long compilation would hold up the recording jobs queued behind it.
+*/
+class VulkanPipelineManager
+{
+public:
+	static constexpr PipelineHandle InvalidHandle = UINT32_MAX;
+
+	VulkanPipelineManager(VulkanRenderDevice* device, ThreadPool* threadPool);
+	// Waits for the compilations still running and destroys every pipeline
+	~VulkanPipelineManager();
+
+	PipelineHandle Create(const VulkanGraphicsPipelineDesc& desc, PipelineHandle fallback = InvalidHandle);
+	// The pipeline must be compiled (or failed) and no longer used by the gpu
+	void Destroy(PipelineHandle handle);
+
+	// Can be called from any thread
+	vk::Pipeline Get(PipelineHandle handle) const;
+	PipelineStatus GetStatus(PipelineHandle handle) const;
+	// Blocks until every queued pipeline is compiled, for loading screens and benchmarks
+	void WaitIdle();
+private:
+	struct Entry
+	{
+		VulkanGraphicsPipelineDesc desc;
+		PipelineHandle fallback;
+		vk::Pipeline pipeline;
+		PipelineStatus status = PipelineStatus::Pending;
+	};
+
+	void compile(PipelineHandle handle);
+private:
+	vk::Device m_Device;
+	vk::PipelineCache m_Cache;
+	ThreadPool* m_ThreadPool;
+
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_Idle;
+	std::vector<Entry> m_Entries;
+	uint32_t m_Pending = 0;
+};
@@ -3,13 +3,33 @@
 #include <GLFW/glfw3.h>
 #include "VulkanImpl/VulkanQueue.h"
 #include "VulkanImpl/VulkanSwapchain.h"
-#include "VulkanImpl/VulkanSwapchain.h"
+#include "VulkanImpl/VulkanOffscreenSwapchain.h"
 #include "VulkanImpl/VulkanSurfaceDetails.h"
 #include "VulkanImpl/VulkanBuffer.h"
-
-constexpr inline static std::array<const char*, 1> GetExtensions()
+#include "VulkanImpl/VulkanImage.h"
+#include "VulkanImpl/VulkanImageView.h"
+#include "VulkanImpl/VulkanMemoryAllocator.h"
+#include "VulkanImpl/VulkanPipelineCache.h"
+#include "VulkanImpl/VulkanLayoutCache.h"
+#include "VulkanImpl/VulkanBindlessHeap.h"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+	// The steady clock reads the performance counter on Windows
+	constexpr VkTimeDomainEXT HostTimeDomain = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+	// and CLOCK_MONOTONIC everywhere else
+	constexpr VkTimeDomainEXT HostTimeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+
+// Headless devices don't present, they don't need the swapchain extension (software drivers may lack it)
+inline static std::vector<const char*> GetExtensions(bool presentation)
 {
-	return {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+	if (presentation)
+		return { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+	return {};
 }
 constexpr inline static vk::PhysicalDeviceFeatures GetFeatures()
 {
@@ -18,6 +38,28 @@ constexpr inline static vk::PhysicalDeviceFeatures GetFeatures()
 	return features;
 }
 
+// The subset of descriptor indexing the bindless heap relies on (checked by selectDevice), non uniform indexing isn't needed
+inline static vk::PhysicalDeviceDescriptorIndexingFeaturesEXT GetDescriptorIndexingFeatures()
+{
+	vk::PhysicalDeviceDescriptorIndexingFeaturesEXT features;
+	features.runtimeDescriptorArray = true;
+	features.descriptorBindingPartiallyBound = true;
+	features.descriptorBindingUpdateUnusedWhilePending = true;
+	features.descriptorBindingSampledImageUpdateAfterBind = true;
+	features.descriptorBindingStorageBufferUpdateAfterBind = true;
+	return features;
+}
+
+inline static bool HasExtension(const std::vector<vk::ExtensionProperties>& extensions, const char* name)
+{
+	for (const auto& extension : extensions)
+	{
+		if (strcmp(extension.extensionName, name) == 0)
+			return true;
+	}
+	return false;
+}
+
 inline static vk::PhysicalDeviceFeatures operator&(const vk::PhysicalDeviceFeatures& a, const vk::PhysicalDeviceFeatures& b)
 {
 	constexpr uint32_t length = sizeof(vk::PhysicalDeviceFeatures) / sizeof(vk::Bool32);
@@ -66,7 +108,7 @@ inline static std::vector<uint32_t> SortBySweatability(std::vector<FamilyInfo>&
 		});
 
 	uint32_t i = 0;
-	while (queueSweatability(families[ptrs[i]].flags, req) != 0)
+	while (i < ptrs.size() && queueSweatability(families[ptrs[i]].flags, req) != 0)
 	{
 		i++;
 	}
@@ -76,21 +118,53 @@ inline static std::vector<uint32_t> SortBySweatability(std::vector<FamilyInfo>&
 }
 
 
-VulkanRenderDevice::VulkanRenderDevice(const std::vector<vk::PhysicalDevice>& physicalDevice, vk::SurfaceKHR surface, GLFWwindow* window, bool useGraphics, bool useCompute)
+VulkanRenderDevice::VulkanRenderDevice(vk::Instance instance, const std::vector<vk::PhysicalDevice>& physicalDevice, vk::SurfaceKHR surface, const RenderDeviceDesc& desc)
 {
+	const bool useGraphics = desc.useGraphics;
+	const bool useCompute = desc.useCompute;
+
 	ASSERT(useGraphics | useCompute, "A device with no queues is not allowed");
 
-	constexpr auto extensions = GetExtensions();
-	constexpr auto features = GetFeatures();
+	auto extensions = GetExtensions(surface);
 	constexpr std::array<float, 3> priorities = { 1,1,1 };
 
 	PhysicalDeviceInfo selected = selectDevice(surface, physicalDevice, useGraphics, useCompute);
 
-	std::vector<vk::DeviceQueueCreateInfo> queueInfos; queueInfos.reserve(3);
+	// Optional features are enabled when present, users check getFeatures() before relying on them
+	auto features = GetFeatures();
+	const vk::PhysicalDeviceFeatures available = selected.physicalDevice.getFeatures();
+	features.shaderStorageImageWriteWithoutFormat = available.shaderStorageImageWriteWithoutFormat;
+	// Indirect draws generated on the gpu, one per object
+	features.multiDrawIndirect = available.multiDrawIndirect;
+	features.drawIndirectFirstInstance = available.drawIndirectFirstInstance;
+
+	const auto avlExtensions = selected.physicalDevice.enumerateDeviceExtensionProperties();
+	// Only used to line gpu timings up with the cpu ones in traces
+	if (HasExtension(avlExtensions, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME))
+		extensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+	// Lets the gpu decide how many indirect draws are read, core in 1.2
+	const bool drawIndirectCount = HasExtension(avlExtensions, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+	if (drawIndirectCount)
+		extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+	// Chained into the device info when the bindless heap can be used
+	auto indexingFeatures = GetDescriptorIndexingFeatures();
+	if (selected.descriptorIndexing)
+	{
+		features.shaderSampledImageArrayDynamicIndexing = true;
+		features.shaderStorageBufferArrayDynamicIndexing = true;
+		extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+		// Core in 1.1, still listed for drivers that report the device as 1.0
+		if (HasExtension(avlExtensions, VK_KHR_MAINTENANCE3_EXTENSION_NAME))
+			extensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+	}
+
+	std::vector<vk::DeviceQueueCreateInfo> queueInfos; queueInfos.reserve(4);
 
 	FamilyInfo* graphicsFamily = nullptr;
 	FamilyInfo* computeFamily = nullptr;
 	FamilyInfo* presentationFamily = nullptr;
+	FamilyInfo* transferFamily = nullptr;
 
 	//Graphics
 	if (useGraphics)
@@ -149,11 +223,27 @@ VulkanRenderDevice::VulkanRenderDevice(const std::vector<vk::PhysicalDevice>& ph
 			ASSERT(presentationFamily, "Not compatible with app");
 		}
 	}
+	//Transfer
+	{
+		// Transfer only families come first, they map to the copy engines and let uploads run next to the rendering
+		for (uint32_t familyIdx : selected.transferQueues)
+		{
+			FamilyInfo* family = selected.getPtr(familyIdx);
+			if (family == graphicsFamily || family == computeFamily || family == presentationFamily || family->count == 0)
+				continue;
+
+			queueInfos.push_back({ {}, familyIdx,1,priorities.data() });
+			family->count--;
+			transferFamily = family;
+			break;
+		}
+	}
 
 	auto deviceInfo = vk::DeviceCreateInfo()
 		.setPpEnabledExtensionNames(extensions.data()).setEnabledExtensionCount(extensions.size())
 		.setPEnabledFeatures(&features)
-		.setPQueueCreateInfos(queueInfos.data()).setQueueCreateInfoCount(queueInfos.size());
+		.setPQueueCreateInfos(queueInfos.data()).setQueueCreateInfoCount(queueInfos.size())
+		.setPNext(selected.descriptorIndexing ? &indexingFeatures : nullptr);
 
 	m_Device = selected.physicalDevice.createDevice(deviceInfo);
 	m_Surface = surface;
@@ -167,48 +257,183 @@ VulkanRenderDevice::VulkanRenderDevice(const std::vector<vk::PhysicalDevice>& ph
 	if (graphicsFamily)
 	{
 		m_GraphicsQueue = m_Device.getQueue(graphicsFamily->familyIdx, 0);
+		m_GraphicsFamily = graphicsFamily->familyIdx;
 		selectedFamilies.push_back(graphicsFamily->familyIdx);
 	}
 	if (computeFamily)
 	{
 		m_ComputeQueue = m_Device.getQueue(computeFamily->familyIdx, (computeFamily == graphicsFamily));
+		m_ComputeFamily = computeFamily->familyIdx;
 		selectedFamilies.push_back(computeFamily->familyIdx);
 	}
 	if (presentationFamily)
 	{ 
 		m_PresentationQueue = m_Device.getQueue(presentationFamily->familyIdx, 0);
+		m_PresentationFamily = presentationFamily->familyIdx;
 		selectedFamilies.push_back(presentationFamily->familyIdx);
 	}
+	if (transferFamily)
+	{
+		m_TransferQueue = m_Device.getQueue(transferFamily->familyIdx, 0);
+		m_TransferFamily = transferFamily->familyIdx;
+	}
+	else
+	{
+		m_TransferQueue = graphicsFamily ? m_GraphicsQueue : m_ComputeQueue;
+		m_TransferFamily = graphicsFamily ? m_GraphicsFamily : m_ComputeFamily;
+	}
 
 	m_PhysicalDevice = selected.physicalDevice;
+	m_Properties = m_PhysicalDevice.getProperties();
+	m_Features = features;
 	for (const auto& q : queueInfos)
-		m_QueueFamilies.push_back(q.queueFamilyIndex);
+		if (q.queueFamilyIndex != m_TransferFamily || !transferFamily)
+			m_QueueFamilies.push_back(q.queueFamilyIndex);
+	// Exclusive resources are handed over from the transfer family with ownership transfers,
+	// concurrent ones must list it to be usable by the transfer queue at all
+	if (transferFamily && m_QueueFamilies.size() > 1)
+		m_QueueFamilies.push_back(m_TransferFamily);
+
+	if (std::find_if(extensions.begin(), extensions.end(), [](const char* e) { return strcmp(e, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) == 0; }) != extensions.end())
+		initCalibratedTimestamps(instance);
+	if (drawIndirectCount)
+		m_DrawIndexedIndirectCount = (PFN_vkCmdDrawIndexedIndirectCountKHR)m_Device.getProcAddr("vkCmdDrawIndexedIndirectCountKHR");
+
+	m_Allocator = new VulkanMemoryAllocator(m_Device, m_PhysicalDevice);
+	m_PipelineCache = new VulkanPipelineCache(m_Device, m_Properties, desc.pipelineCacheDirectory);
+	m_LayoutCache = new VulkanLayoutCache(m_Device);
+
+	if (selected.descriptorIndexing)
+	{
+		m_DescriptorIndexing = true;
+		m_DescriptorIndexingProperties = m_PhysicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorIndexingPropertiesEXT>()
+			.get<vk::PhysicalDeviceDescriptorIndexingPropertiesEXT>();
+		m_BindlessHeap = new VulkanBindlessHeap(this, { desc.framesInFlight });
+	}
 
 	//Swapchain
-	VulkanSwapchainDesc swapchainDesc;
+	if (surface)
 	{
-		int w, h;	glfwGetWindowSize(window, &w, &h);
-		auto swapDetails = getSurfaceDetail();
-
-		swapchainDesc.presentMode = PresentMode::VSync;
-		swapchainDesc.imagesDimensions = { (uint32_t)w,(uint32_t)h };
-		swapchainDesc.presentationQueue = m_PresentationQueue;
-		swapchainDesc.queueFamilies = { selectedFamilies.begin(),selectedFamilies.end() };
-		swapchainDesc.surfaceDetails = getSurfaceDetail();
+		VulkanSwapchainDesc swapchainDesc;
+		{
+			int w, h;	glfwGetFramebufferSize(desc.window, &w, &h);
+
+			swapchainDesc.presentMode = PresentMode::VSync;
+			swapchainDesc.imagesDimensions = { (uint32_t)w,(uint32_t)h };
+			swapchainDesc.presentationQueue = m_PresentationQueue;
+			swapchainDesc.queueFamilies = { selectedFamilies.begin(),selectedFamilies.end() };
+			swapchainDesc.surfaceDetails = getSurfaceDetail();
+			swapchainDesc.physicalDevice = m_PhysicalDevice;
+			swapchainDesc.framesInFlight = desc.framesInFlight;
+		}
+
+		m_Swapchain = new VulkanSwapchain(m_Device, swapchainDesc);
 	}
+	else
+	{
+		VulkanOffscreenSwapchainDesc swapchainDesc;
+		{
+			swapchainDesc.presentMode = PresentMode::Imidiate;
+			swapchainDesc.imagesDimensions = desc.offscreenDimensions;
+			swapchainDesc.queueFamily = graphicsFamily ? m_GraphicsFamily : m_ComputeFamily;
+			swapchainDesc.queue = graphicsFamily ? m_GraphicsQueue : m_ComputeQueue;
+			swapchainDesc.allocator = m_Allocator;
+			swapchainDesc.framesInFlight = desc.framesInFlight;
+		}
 
-	m_Swapchain = new VulkanSwapchain(m_Device, swapchainDesc);
+		m_Swapchain = new VulkanOffscreenSwapchain(m_Device, swapchainDesc);
+	}
 }
 
 VulkanRenderDevice::~VulkanRenderDevice()
 {
 	delete m_Swapchain;
+	delete m_Allocator;
+
+	m_PipelineCache->Save();
+	delete m_PipelineCache;
+	delete m_BindlessHeap;
+	delete m_LayoutCache;
+
 	m_Device.destroy();
 }
 
 Buffer* VulkanRenderDevice::CreateBuffer(const BufferDesc& desc) const
 {
-	return new VulkanBuffer(m_Device, { desc,m_PhysicalDevice,m_QueueFamilies });
+	return new VulkanBuffer(m_Device, { desc,m_Allocator,m_QueueFamilies });
+}
+
+Image* VulkanRenderDevice::CreateImage(const ImageDesc& desc) const
+{
+	VulkanImageDesc imageDesc;
+	static_cast<ImageDesc&>(imageDesc) = desc;
+	imageDesc.allocator = m_Allocator;
+
+	return new VulkanImage(m_Device, imageDesc);
+}
+
+ImageView* VulkanRenderDevice::CreateImageView(const ImageViewDesc& desc) const
+{
+	VulkanImageViewDesc viewDesc;
+	static_cast<ImageViewDesc&>(viewDesc) = desc;
+
+	return new VulkanImageView(m_Device, viewDesc);
+}
+
+vk::PipelineCache VulkanRenderDevice::getPipelineCache()
+{
+	return m_PipelineCache->getVkPipelineCache();
+}
+
+bool VulkanRenderDevice::getCalibratedTimestamp(uint64_t& deviceTicks, std::chrono::steady_clock::time_point& hostTime)
+{
+	if (!m_GetCalibratedTimestamps)
+		return false;
+
+	std::array<VkCalibratedTimestampInfoEXT, 2> infos = {};
+	infos[0].sType = infos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+	infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+	infos[1].timeDomain = m_HostTimeDomain;
+
+	std::array<uint64_t, 2> timestamps;
+	uint64_t maxDeviation;
+	if (m_GetCalibratedTimestamps(m_Device, infos.size(), infos.data(), timestamps.data(), &maxDeviation) != VK_SUCCESS)
+		return false;
+
+	deviceTicks = timestamps[0];
+#ifdef _WIN32
+	static const uint64_t frequency = [] { LARGE_INTEGER f; QueryPerformanceFrequency(&f); return (uint64_t)f.QuadPart; }();
+	const uint64_t nanoseconds = (timestamps[1] / frequency) * 1000000000ull + (timestamps[1] % frequency) * 1000000000ull / frequency;
+#else
+	const uint64_t nanoseconds = timestamps[1];
+#endif
+	hostTime = std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(nanoseconds)));
+	return true;
+}
+
+inline void VulkanRenderDevice::initCalibratedTimestamps(vk::Instance instance)
+{
+	auto getTimeDomains = (PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)instance.getProcAddr("vkGetPhysicalDeviceCalibrateableTimeDomainsEXT");
+	if (!getTimeDomains)
+		return;
+
+	uint32_t count = 0;
+	getTimeDomains(m_PhysicalDevice, &count, nullptr);
+	std::vector<VkTimeDomainEXT> domains(count);
+	getTimeDomains(m_PhysicalDevice, &count, domains.data());
+
+	const bool hasDevice = std::find(domains.begin(), domains.end(), VK_TIME_DOMAIN_DEVICE_EXT) != domains.end();
+	const bool hasHost = std::find(domains.begin(), domains.end(), HostTimeDomain) != domains.end();
+	if (!hasDevice || !hasHost)
+		return;
+
+	m_HostTimeDomain = HostTimeDomain;
+	m_GetCalibratedTimestamps = (PFN_vkGetCalibratedTimestampsEXT)m_Device.getProcAddr("vkGetCalibratedTimestampsEXT");
+}
+
+MemoryStats VulkanRenderDevice::GetMemoryStats() const
+{
+	return m_Allocator->GetStats();
 }
 
 /*TODO: Rewrite
@@ -217,7 +442,7 @@ Buffer* VulkanRenderDevice::CreateBuffer(const BufferDesc& desc) const
 */
 inline PhysicalDeviceInfo VulkanRenderDevice::selectDevice(vk::SurfaceKHR surface, const std::vector<vk::PhysicalDevice>& physicalDevices, bool useGraphics, bool useCompute)
 {
-	auto reqExtensions = GetExtensions();
+	auto reqExtensions = GetExtensions(surface);
 	auto reqFeatures = GetFeatures();
 
 	float bestScore = -std::numeric_limits<float>::infinity();
@@ -227,6 +452,8 @@ inline PhysicalDeviceInfo VulkanRenderDevice::selectDevice(vk::SurfaceKHR surfac
 	std::vector<FamilyInfo> bestFamilies;
 	std::vector<uint32_t> bestGraphics;
 	std::vector<uint32_t> bestCompute;
+	std::vector<uint32_t> bestTransfer;
+	bool bestDescriptorIndexing = false;
 
 	for (const auto& device : physicalDevices)
 	{
@@ -240,6 +467,8 @@ inline PhysicalDeviceInfo VulkanRenderDevice::selectDevice(vk::SurfaceKHR surfac
 		std::vector<FamilyInfo> familiesInfos(avlFamilies.size());
 		std::vector<uint32_t> sortedGraphics;
 		std::vector<uint32_t> sortedCompute;
+		std::vector<uint32_t> sortedTransfer;
+		bool descriptorIndexing = false;
 
 		for (uint32_t i = 0; i < avlFamilies.size(); i++) familiesInfos[i] = { i,avlFamilies[i].queueCount,avlFamilies[i].queueFlags,false };
 
@@ -270,6 +499,18 @@ inline PhysicalDeviceInfo VulkanRenderDevice::selectDevice(vk::SurfaceKHR surfac
 				goto END;
 			}
 		}
+		//Check descriptor indexing support (optional)
+		if (HasExtension(avlExtensions, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+		{
+			const auto avlIndexing = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDescriptorIndexingFeaturesEXT>()
+				.get<vk::PhysicalDeviceDescriptorIndexingFeaturesEXT>();
+
+			// The bindless shaders index the arrays with push constants
+			descriptorIndexing = avlFeatures.shaderSampledImageArrayDynamicIndexing && avlFeatures.shaderStorageBufferArrayDynamicIndexing
+				&& avlIndexing.runtimeDescriptorArray && avlIndexing.descriptorBindingPartiallyBound
+				&& avlIndexing.descriptorBindingUpdateUnusedWhilePending
+				&& avlIndexing.descriptorBindingSampledImageUpdateAfterBind && avlIndexing.descriptorBindingStorageBufferUpdateAfterBind;
+		}
 		//Check family support
 		{
 			//Graphics
@@ -298,6 +539,10 @@ inline PhysicalDeviceInfo VulkanRenderDevice::selectDevice(vk::SurfaceKHR surfac
 					goto END;
 				}
 			}
+			//Transfer (optional, the graphics/compute queue is used otherwise)
+			{
+				sortedTransfer = SortBySweatability(familiesInfos, vk::QueueFlagBits::eTransfer);
+			}
 			//Presenting
 			if (surface)
 			{
@@ -318,6 +563,7 @@ inline PhysicalDeviceInfo VulkanRenderDevice::selectDevice(vk::SurfaceKHR surfac
 		if (props.deviceType == vk::PhysicalDeviceType::eDiscreteGpu) score += 1000;
 		if (surface && useGraphics && sortedGraphics[0]) score += 1000;
 		if (useGraphics && useCompute && (sortedGraphics[0] != sortedCompute[0])) score += 100;
+		if (sortedTransfer.size() && !(familiesInfos[sortedTransfer[0]].flags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute))) score += 10;
 
 	END:
 		if (score > bestScore)
@@ -328,6 +574,8 @@ inline PhysicalDeviceInfo VulkanRenderDevice::selectDevice(vk::SurfaceKHR surfac
 			bestFamilies = std::move(familiesInfos);
 			bestGraphics = std::move(sortedGraphics);
 			bestCompute = std::move(sortedCompute);
+			bestTransfer = std::move(sortedTransfer);
+			bestDescriptorIndexing = descriptorIndexing;
 		}
 
 		i++;
@@ -341,7 +589,9 @@ inline PhysicalDeviceInfo VulkanRenderDevice::selectDevice(vk::SurfaceKHR surfac
 		physicalDevices[bestDeviceIdx],
 		bestFamilies,
 		bestGraphics,
-		bestCompute
+		bestCompute,
+		bestTransfer,
+		bestDescriptorIndexing
 	};
 
 	/*			auto queueSweatability = [](vk::QueueFlags a, vk::QueueFlags req)
@@ -3,8 +3,13 @@
 #include "abstraction/RenderDevice.h"
 #include "abstraction/Queue.h"
 #include <vulkan/vulkan.hpp>
+#include <chrono>
 
 struct VulkanSurfaceDetails;
+class VulkanMemoryAllocator;
+class VulkanPipelineCache;
+class VulkanLayoutCache;
+class VulkanBindlessHeap;
 
 struct FamilyInfo
 {
@@ -20,6 +25,9 @@ struct PhysicalDeviceInfo
 	std::vector<FamilyInfo> familiesInfos;
 	std::vector<uint32_t> graphicsQueues;
 	std::vector<uint32_t> computeQueues;
+	std::vector<uint32_t> transferQueues;
+	// VK_EXT_descriptor_indexing with everything the bindless heap needs
+	bool descriptorIndexing = false;
 
 	inline uint32_t& getCount(uint32_t i) { return familiesInfos[i].count; };
 	inline bool& getPresentCapability(uint32_t i) { return familiesInfos[i].presentationCapable; };
@@ -31,10 +39,15 @@ class VulkanRenderDevice : public RenderDevice
 public:
 	friend class VulkanRenderInstance;
 
-	VulkanRenderDevice(const std::vector<vk::PhysicalDevice>& physicalDevice,vk::SurfaceKHR surface, GLFWwindow* window, bool useGraphics,bool useCompute);
+	VulkanRenderDevice(vk::Instance instance, const std::vector<vk::PhysicalDevice>& physicalDevice,vk::SurfaceKHR surface, const RenderDeviceDesc& desc);
 	~VulkanRenderDevice();						
 
 	virtual Buffer* CreateBuffer(const BufferDesc& desc) const override;
+	// Images are created with exclusive sharing, moving them between families takes ownership transfers
+	virtual Image* CreateImage(const ImageDesc& desc) const override;
+	virtual ImageView* CreateImageView(const ImageViewDesc& desc) const override;
+
+	virtual MemoryStats GetMemoryStats() const override;
 		
 	inline virtual Swapchain* GetSwapchain() override { return m_Swapchain; }
 	inline virtual const Swapchain* GetSwapchain() const override { return m_Swapchain; }
@@ -43,17 +56,43 @@ public:
 	inline vk::Queue getGraphicsQueue() { return m_GraphicsQueue; }
 	inline vk::Queue getComputeQueue() { return m_ComputeQueue; }
 	inline vk::Queue getPresentationQueue() { return m_PresentationQueue; }
+	// Falls back to the graphics (or compute) queue when the device has no spare transfer capable family
+	inline vk::Queue getTransferQueue() { return m_TransferQueue; }
+	inline uint32_t getGraphicsFamily() { return m_GraphicsFamily; }
+	inline uint32_t getComputeFamily() { return m_ComputeFamily; }
+	inline uint32_t getPresentationFamily() { return m_PresentationFamily; }
+	inline uint32_t getTransferFamily() { return m_TransferFamily; }
 	inline vk::PhysicalDevice getPhysicalDevice() { return m_PhysicalDevice; }
+	inline const vk::PhysicalDeviceProperties& getProperties() { return m_Properties; }
+	inline const vk::PhysicalDeviceLimits& getLimits() { return m_Properties.limits; }
+	inline const vk::PhysicalDeviceFeatures& getFeatures() { return m_Features; }
 	inline vk::SurfaceKHR getSurface() { return m_Surface; }
+	// No window : the swapchain is an offscreen image ring and the images are never presented
+	inline bool isHeadless() { return !m_Surface; }
+	inline VulkanMemoryAllocator* getAllocator() { return m_Allocator; }
+	vk::PipelineCache getPipelineCache();
+	inline VulkanLayoutCache* getLayoutCache() { return m_LayoutCache; }
+	// Null when the device doesn't support descriptor indexing
+	inline VulkanBindlessHeap* getBindlessHeap() { return m_BindlessHeap; }
+	inline bool hasDescriptorIndexing() const { return m_DescriptorIndexing; }
+	inline const vk::PhysicalDeviceDescriptorIndexingPropertiesEXT& getDescriptorIndexingProperties() const { return m_DescriptorIndexingProperties; }
+	// Samples the device timestamp counter and the steady clock at the same instant (VK_EXT_calibrated_timestamps),
+	// returns false when the device can't do it
+	bool getCalibratedTimestamp(uint64_t& deviceTicks, std::chrono::steady_clock::time_point& hostTime);
+	// vkCmdDrawIndexedIndirectCountKHR, null when the device doesn't have VK_KHR_draw_indirect_count
+	inline PFN_vkCmdDrawIndexedIndirectCountKHR getDrawIndexedIndirectCount() const { return m_DrawIndexedIndirectCount; }
 
 private:																												 
 	inline PhysicalDeviceInfo selectDevice(vk::SurfaceKHR surface, const std::vector<vk::PhysicalDevice>& physicalDevice,bool useGraphics,bool useCompute);
 	inline VulkanSurfaceDetails getSurfaceDetail();
+	inline void initCalibratedTimestamps(vk::Instance instance);
 	
 private:
 	vk::Device m_Device;
 	vk::SurfaceKHR m_Surface;
 	vk::PhysicalDevice m_PhysicalDevice;
+	vk::PhysicalDeviceProperties m_Properties;
+	vk::PhysicalDeviceFeatures m_Features;
 
 	std::vector<uint32_t> m_QueueFamilies;
 	//std::unique_ptr<Queue> m_GraphicsQueue = nullptr;
@@ -61,8 +100,26 @@ private:
 	//std::unique_ptr<Queue> m_PresentationQueue = nullptr;
 
 	Swapchain* m_Swapchain;
+	VulkanMemoryAllocator* m_Allocator;
+	VulkanPipelineCache* m_PipelineCache;
+	VulkanLayoutCache* m_LayoutCache;
+	VulkanBindlessHeap* m_BindlessHeap = nullptr;
+
+	bool m_DescriptorIndexing = false;
+	vk::PhysicalDeviceDescriptorIndexingPropertiesEXT m_DescriptorIndexingProperties;
 
 	vk::Queue m_GraphicsQueue = nullptr;
 	vk::Queue m_ComputeQueue = nullptr;
 	vk::Queue m_PresentationQueue = nullptr;
+	vk::Queue m_TransferQueue = nullptr;
+
+	uint32_t m_GraphicsFamily = VK_QUEUE_FAMILY_IGNORED;
+	uint32_t m_ComputeFamily = VK_QUEUE_FAMILY_IGNORED;
+	uint32_t m_PresentationFamily = VK_QUEUE_FAMILY_IGNORED;
+	uint32_t m_TransferFamily = VK_QUEUE_FAMILY_IGNORED;
+
+	// Null when the extension is missing or the host clock isn't one of its time domains
+	PFN_vkGetCalibratedTimestampsEXT m_GetCalibratedTimestamps = nullptr;
+	PFN_vkCmdDrawIndexedIndirectCountKHR m_DrawIndexedIndirectCount = nullptr;
+	VkTimeDomainEXT m_HostTimeDomain;
 };
\ No newline at end of file
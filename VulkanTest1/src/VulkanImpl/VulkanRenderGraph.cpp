@@ -0,0 +1,931 @@
+#include "pch.h"
+#include "VulkanRenderGraph.h"
+#include "VulkanImage.h"
+#include "VulkanImageView.h"
+#include "VulkanBuffer.h"
+#include "VulkanGpuProfiler.h"
+#include "Tracing.h"
+#include "Conversions.h"
+#include <algorithm>
+
+struct RenderGraphAccess
+{
+	uint32_t resource;
+	RenderGraphUsage usage;
+	bool write;
+	bool clear;
+	vk::ClearValue clearValue;
+};
+
+struct RenderGraphPass
+{
+	std::string name;
+	uint32_t index;
+	VulkanRenderGraph::ExecuteFunction execute;
+
+	std::vector<RenderGraphAccess> accesses;
+	// Passes that have to run before this one, from read after write, write after write and write after read
+	std::vector<uint32_t> dependencies;
+	bool secondaryBuffers = false;
+	bool sideEffects = false;
+	bool culled = false;
+
+	// Filled by Compile()
+	std::vector<vk::ImageMemoryBarrier> imageBarriers;
+	vk::MemoryBarrier memoryBarrier;
+	vk::PipelineStageFlags srcStages, dstStages;
+
+	vk::RenderPass renderPass;
+	vk::Framebuffer framebuffer;
+	vk::Extent2D extent;
+	std::vector<vk::ClearValue> clearValues;
+};
+
+struct RenderGraphResourceNode
+{
+	std::string name;
+	bool isImage;
+	bool imported;
+	bool output = false;
+
+	vk::Image image;
+	vk::ImageView view;
+	vk::Format format;
+	vk::Extent2D extent;
+	vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1;
+	vk::ImageAspectFlags aspect;
+
+	RenderGraphImportedImage importInfo;
+	RenderGraphImageDesc transientDesc;
+	uint32_t transientIndex = UINT32_MAX;
+	vk::ImageUsageFlags usage;
+
+	vk::Buffer buffer;
+
+	// Declaration tracking, to find the dependencies of the passes
+	uint32_t lastWriter = UINT32_MAX;
+	std::vector<uint32_t> readersSinceWrite;
+
+	// Positions in the execution order
+	uint32_t firstUse = UINT32_MAX, lastUse = 0;
+};
+
+struct UsageInfo
+{
+	vk::PipelineStageFlags stages;
+	vk::AccessFlags access;
+	vk::ImageLayout layout;
+	vk::ImageUsageFlags imageUsage;
+	bool attachment;
+};
+
+static UsageInfo GetUsageInfo(RenderGraphUsage usage, bool write)
+{
+	using Stage = vk::PipelineStageFlagBits;
+	using Access = vk::AccessFlagBits;
+	using Layout = vk::ImageLayout;
+	using Usage = vk::ImageUsageFlagBits;
+
+	switch (usage)
+	{
+	case RenderGraphUsage::ColorAttachment:
+		return { Stage::eColorAttachmentOutput, write ? Access::eColorAttachmentRead | Access::eColorAttachmentWrite : Access::eColorAttachmentRead,
+			Layout::eColorAttachmentOptimal, Usage::eColorAttachment, true };
+	case RenderGraphUsage::DepthStencilAttachment:
+		return { Stage::eEarlyFragmentTests | Stage::eLateFragmentTests,
+			write ? Access::eDepthStencilAttachmentRead | Access::eDepthStencilAttachmentWrite : Access::eDepthStencilAttachmentRead,
+			write ? Layout::eDepthStencilAttachmentOptimal : Layout::eDepthStencilReadOnlyOptimal, Usage::eDepthStencilAttachment, true };
+	case RenderGraphUsage::SampledFragment:
+		return { Stage::eFragmentShader, Access::eShaderRead, Layout::eShaderReadOnlyOptimal, Usage::eSampled, false };
+	case RenderGraphUsage::SampledCompute:
+		return { Stage::eComputeShader, Access::eShaderRead, Layout::eShaderReadOnlyOptimal, Usage::eSampled, false };
+	case RenderGraphUsage::StorageReadCompute:
+		return { Stage::eComputeShader, Access::eShaderRead, Layout::eGeneral, Usage::eStorage, false };
+	case RenderGraphUsage::StorageWriteCompute:
+		// Written storage is usually read too (atomics, read-modify-write)
+		return { Stage::eComputeShader, write ? Access::eShaderRead | Access::eShaderWrite : Access::eShaderRead, Layout::eGeneral, Usage::eStorage, false };
+	case RenderGraphUsage::TransferSrc:
+		return { Stage::eTransfer, Access::eTransferRead, Layout::eTransferSrcOptimal, Usage::eTransferSrc, false };
+	case RenderGraphUsage::TransferDst:
+		return { Stage::eTransfer, Access::eTransferWrite, Layout::eTransferDstOptimal, Usage::eTransferDst, false };
+	case RenderGraphUsage::VertexBuffer:
+		return { Stage::eVertexInput, Access::eVertexAttributeRead, Layout::eUndefined, {}, false };
+	case RenderGraphUsage::IndexBuffer:
+		return { Stage::eVertexInput, Access::eIndexRead, Layout::eUndefined, {}, false };
+	case RenderGraphUsage::UniformBuffer:
+		return { Stage::eVertexShader | Stage::eFragmentShader, Access::eUniformRead, Layout::eUndefined, {}, false };
+	case RenderGraphUsage::IndirectBuffer:
+		return { Stage::eDrawIndirect, Access::eIndirectCommandRead, Layout::eUndefined, {}, false };
+	default:
+		ASSERT(false, "Unknown render graph usage (value = %u)", (uint32_t)usage);
+		return {};
+	}
+}
+
+static vk::ImageAspectFlags GetAspect(vk::Format format)
+{
+	switch (format)
+	{
+	case vk::Format::eD32Sfloat:
+	case vk::Format::eD16Unorm:
+		return vk::ImageAspectFlagBits::eDepth;
+	case vk::Format::eS8Uint:
+		return vk::ImageAspectFlagBits::eStencil;
+	case vk::Format::eD24UnormS8Uint:
+		return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+	default:
+		return vk::ImageAspectFlagBits::eColor;
+	}
+}
+
+static inline bool IsDepthLayout(vk::ImageLayout layout)
+{
+	return layout == vk::ImageLayout::eDepthStencilAttachmentOptimal || layout == vk::ImageLayout::eDepthStencilReadOnlyOptimal;
+}
+
+void VulkanRenderGraph::PassBuilder::Read(RenderGraphResource resource, RenderGraphUsage usage)
+{
+	access(resource, usage, false, nullptr);
+}
+
+void VulkanRenderGraph::PassBuilder::Write(RenderGraphResource resource, RenderGraphUsage usage)
+{
+	access(resource, usage, true, nullptr);
+}
+
+void VulkanRenderGraph::PassBuilder::Write(RenderGraphResource resource, RenderGraphUsage usage, const vk::ClearValue& clear)
+{
+	access(resource, usage, true, &clear);
+}
+
+void VulkanRenderGraph::PassBuilder::UseSecondaryCommandBuffers()
+{
+	m_Pass->secondaryBuffers = true;
+}
+
+void VulkanRenderGraph::PassBuilder::SetSideEffects()
+{
+	m_Pass->sideEffects = true;
+}
+
+void VulkanRenderGraph::PassBuilder::access(RenderGraphResource resource, RenderGraphUsage usage, bool write, const vk::ClearValue* clear)
+{
+	ASSERT(resource.IsValid() && resource.id < m_Graph->m_Resources.size(), "Invalid resource used by pass '%s'", m_Pass->name.c_str());
+
+	RenderGraphResourceNode& node = m_Graph->m_Resources[resource.id];
+	for (const auto& other : m_Pass->accesses)
+		ASSERT(other.resource != resource.id, "Pass '%s' uses '%s' more than once", m_Pass->name.c_str(), node.name.c_str());
+	ASSERT(node.isImage || !GetUsageInfo(usage, write).attachment, "Buffer '%s' can't be used as an attachment", node.name.c_str());
+	ASSERT(!clear || GetUsageInfo(usage, write).attachment, "Only attachments can be cleared ('%s')", node.name.c_str());
+
+	RenderGraphAccess access;
+	access.resource = resource.id;
+	access.usage = usage;
+	access.write = write;
+	access.clear = clear != nullptr;
+	if (clear)
+		access.clearValue = *clear;
+	m_Pass->accesses.push_back(access);
+
+	if (node.lastWriter != UINT32_MAX)
+		m_Pass->dependencies.push_back(node.lastWriter);
+
+	if (write)
+	{
+		for (uint32_t reader : node.readersSinceWrite)
+			if (reader != m_Pass->index)
+				m_Pass->dependencies.push_back(reader);
+
+		node.lastWriter = m_Pass->index;
+		node.readersSinceWrite.clear();
+	}
+	else
+	{
+		node.readersSinceWrite.push_back(m_Pass->index);
+	}
+}
+
+VulkanRenderGraph::VulkanRenderGraph(VulkanRenderDevice* device, uint32_t framesInFlight)
+	:m_Device(device), m_VkDevice(device->getDevice()), m_FramesInFlight(framesInFlight)
+{
+}
+
+VulkanRenderGraph::~VulkanRenderGraph()
+{
+	retireTransients();
+	ResetFramebuffers();
+	collect(true);
+
+	for (const auto& [key, renderPass] : m_RenderPasses)
+		m_VkDevice.destroyRenderPass(renderPass);
+}
+
+void VulkanRenderGraph::BeginFrame(uint64_t frameNumber)
+{
+	m_FrameNumber = frameNumber;
+	collect(false);
+
+	m_Resources.clear();
+	m_Passes.clear();
+	m_Order.clear();
+	m_FinalBarriers.clear();
+	m_TransientCount = 0;
+	m_Compiled = false;
+}
+
+RenderGraphResource VulkanRenderGraph::ImportImage(const std::string& name, const RenderGraphImportedImage& image)
+{
+	ASSERT(image.view, "Imported image '%s' has no view", name.c_str());
+
+	VulkanImageView* view = static_cast<VulkanImageView*>(image.view);
+	VulkanImage* handle = static_cast<VulkanImage*>(view->getImage());
+	const ImageDesc& desc = handle->GetDesc();
+
+	RenderGraphResourceNode node;
+	node.name = name;
+	node.isImage = true;
+	node.imported = true;
+	node.output = image.finalLayout != vk::ImageLayout::eUndefined;
+	node.image = handle->getVkImage();
+	node.view = view->getVkView();
+	node.format = handle->getVkFormat();
+	node.extent = vk::Extent2D(desc.dimensions.width, desc.dimensions.height);
+	node.samples = GetVkSampleCount(desc.samples);
+	node.aspect = GetAspect(node.format);
+	node.importInfo = image;
+
+	m_Resources.push_back(std::move(node));
+	return { (uint32_t)m_Resources.size() - 1 };
+}
+
+RenderGraphResource VulkanRenderGraph::ImportBuffer(const std::string& name, Buffer* buffer)
+{
+	RenderGraphResourceNode node;
+	node.name = name;
+	node.isImage = false;
+	node.imported = true;
+	node.buffer = static_cast<VulkanBuffer*>(buffer)->getVkBuffer();
+
+	m_Resources.push_back(std::move(node));
+	return { (uint32_t)m_Resources.size() - 1 };
+}
+
+RenderGraphResource VulkanRenderGraph::CreateImage(const std::string& name, const RenderGraphImageDesc& desc)
+{
+	RenderGraphResourceNode node;
+	node.name = name;
+	node.isImage = true;
+	node.imported = false;
+	node.format = GetVkFormat(desc.format);
+	node.extent = vk::Extent2D(desc.dimensions.width, desc.dimensions.height);
+	node.samples = GetVkSampleCount(desc.samples);
+	node.aspect = GetAspect(node.format);
+	node.transientDesc = desc;
+	node.transientIndex = m_TransientCount++;
+
+	m_Resources.push_back(std::move(node));
+	return { (uint32_t)m_Resources.size() - 1 };
+}
+
+void VulkanRenderGraph::AddPass(const std::string& name, const SetupFunction& setup, const ExecuteFunction& execute)
+{
+	ASSERT(!m_Compiled, "Pass '%s' added after the graph was compiled", name.c_str());
+
+	m_Passes.emplace_back();
+	RenderGraphPass& pass = m_Passes.back();
+	pass.name = name;
+	pass.index = (uint32_t)m_Passes.size() - 1;
+	pass.execute = execute;
+
+	PassBuilder builder(this, &pass);
+	setup(builder);
+}
+
+void VulkanRenderGraph::Compile()
+{
+	ASSERT(!m_Compiled, "The graph is already compiled");
+	TRACE_ZONE("Render graph compile");
+
+	cull();
+	schedule();
+	allocateTransients();
+	buildBarriers();
+
+	m_Compiled = true;
+}
+
+void VulkanRenderGraph::Execute(vk::CommandBuffer commandBuffer, VulkanGpuProfiler* profiler)
+{
+	ASSERT(m_Compiled, "The graph has to be compiled before being executed");
+
+	for (uint32_t passIndex : m_Order)
+	{
+		RenderGraphPass& pass = m_Passes[passIndex];
+
+		if (pass.imageBarriers.size() || pass.memoryBarrier.srcAccessMask || pass.memoryBarrier.dstAccessMask || pass.srcStages)
+		{
+			if (pass.memoryBarrier.srcAccessMask || pass.memoryBarrier.dstAccessMask)
+				commandBuffer.pipelineBarrier(pass.srcStages, pass.dstStages, {}, pass.memoryBarrier, nullptr, pass.imageBarriers);
+			else
+				commandBuffer.pipelineBarrier(pass.srcStages, pass.dstStages, {}, nullptr, nullptr, pass.imageBarriers);
+		}
+
+		TRACE_ZONE(pass.name.c_str());
+		// Outside of the render pass, nothing but executeCommands is allowed in a pass recorded in secondary buffers
+		VulkanGpuProfiler::Scope scope(profiler, commandBuffer, pass.name);
+
+		RenderGraphPassContext context;
+		context.commandBuffer = commandBuffer;
+
+		if (pass.renderPass)
+		{
+			context.renderPass = pass.renderPass;
+			context.framebuffer = pass.framebuffer;
+			context.extent = pass.extent;
+
+			auto beginInfo = vk::RenderPassBeginInfo()
+				.setRenderPass(pass.renderPass)
+				.setFramebuffer(pass.framebuffer)
+				.setRenderArea({ {0,0},pass.extent })
+				.setClearValueCount(pass.clearValues.size()).setPClearValues(pass.clearValues.data());
+
+			commandBuffer.beginRenderPass(beginInfo, pass.secondaryBuffers ? vk::SubpassContents::eSecondaryCommandBuffers : vk::SubpassContents::eInline);
+			pass.execute(context);
+			commandBuffer.endRenderPass();
+		}
+		else
+		{
+			pass.execute(context);
+		}
+	}
+
+	if (m_FinalBarriers.size())
+		commandBuffer.pipelineBarrier(m_FinalSrcStages, vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, nullptr, m_FinalBarriers);
+}
+
+vk::ImageView VulkanRenderGraph::GetImageView(RenderGraphResource resource) const
+{
+	ASSERT(m_Compiled && resource.id < m_Resources.size(), "Invalid image view request");
+	return m_Resources[resource.id].view;
+}
+
+vk::Buffer VulkanRenderGraph::GetBuffer(RenderGraphResource resource) const
+{
+	ASSERT(m_Compiled && resource.id < m_Resources.size(), "Invalid buffer request");
+	return m_Resources[resource.id].buffer;
+}
+
+vk::RenderPass VulkanRenderGraph::GetCompatibleRenderPass(const std::vector<ImageFormat>& colorFormats, ImageFormat depthFormat, bool hasDepth, uint32_t samples)
+{
+	// Compatibility only depends on formats and sample counts, the ops are the ones a cleared and kept attachment gets
+	std::vector<AttachmentKey> keys;
+	for (ImageFormat format : colorFormats)
+		keys.push_back({ GetVkFormat(format), GetVkSampleCount(samples), vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eStore, vk::ImageLayout::eColorAttachmentOptimal });
+	if (hasDepth)
+		keys.push_back({ GetVkFormat(depthFormat), GetVkSampleCount(samples), vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eDontCare, vk::ImageLayout::eDepthStencilAttachmentOptimal });
+
+	return getRenderPass(keys);
+}
+
+void VulkanRenderGraph::ResetFramebuffers()
+{
+	Retired retired;
+	retired.frame = m_FrameNumber + m_FramesInFlight;
+	for (const auto& [key, framebuffer] : m_Framebuffers)
+		retired.framebuffers.push_back(framebuffer);
+	m_Framebuffers.clear();
+
+	m_Retired.push_back(std::move(retired));
+}
+
+void VulkanRenderGraph::cull()
+{
+	// Walking backwards, a pass is needed if it writes something needed later on, its reads become needed in turn.
+	// Clearing an attachment starts a new version of the resource, whatever was written before is not needed for it
+	std::vector<bool> needed(m_Resources.size());
+	for (uint32_t i = 0; i < m_Resources.size(); i++)
+		needed[i] = m_Resources[i].output;
+
+	m_CulledPasses = 0;
+	for (uint32_t i = m_Passes.size(); i-- > 0;)
+	{
+		RenderGraphPass& pass = m_Passes[i];
+
+		bool keep = pass.sideEffects;
+		for (const auto& access : pass.accesses)
+			keep |= access.write && needed[access.resource];
+
+		pass.culled = !keep;
+		if (pass.culled)
+		{
+			m_CulledPasses++;
+			continue;
+		}
+
+		for (const auto& access : pass.accesses)
+		{
+			if (access.write && access.clear)
+				needed[access.resource] = false;
+			else
+				needed[access.resource] = true;
+		}
+	}
+}
+
+void VulkanRenderGraph::schedule()
+{
+	// Topological order where, among the passes that are ready, the one whose inputs were produced the earliest goes first :
+	// independent work ends up between producers and consumers, so the barriers find their source stages already done
+	std::vector<uint32_t> position(m_Passes.size(), UINT32_MAX);
+	std::vector<bool> scheduled(m_Passes.size(), false);
+
+	uint32_t remaining = 0;
+	for (const auto& pass : m_Passes)
+		remaining += !pass.culled;
+
+	while (remaining)
+	{
+		uint32_t best = UINT32_MAX;
+		uint32_t bestReadyAt = UINT32_MAX;
+
+		for (const auto& pass : m_Passes)
+		{
+			if (pass.culled || scheduled[pass.index])
+				continue;
+
+			bool ready = true;
+			uint32_t readyAt = 0;
+			for (uint32_t dependency : pass.dependencies)
+			{
+				if (m_Passes[dependency].culled)
+					continue;
+				if (!scheduled[dependency])
+				{
+					ready = false;
+					break;
+				}
+				readyAt = std::max(readyAt, position[dependency] + 1);
+			}
+
+			if (ready && readyAt < bestReadyAt)
+			{
+				best = pass.index;
+				bestReadyAt = readyAt;
+			}
+		}
+
+		ASSERT(best != UINT32_MAX, "The render graph has a dependency cycle");
+
+		scheduled[best] = true;
+		position[best] = m_Order.size();
+		m_Order.push_back(best);
+		remaining--;
+	}
+
+	for (uint32_t i = 0; i < m_Order.size(); i++)
+	{
+		for (const auto& access : m_Passes[m_Order[i]].accesses)
+		{
+			RenderGraphResourceNode& node = m_Resources[access.resource];
+			node.firstUse = std::min(node.firstUse, i);
+			node.lastUse = std::max(node.lastUse, i);
+			if (node.isImage)
+				node.usage |= GetUsageInfo(access.usage, access.write).imageUsage;
+		}
+	}
+}
+
+void VulkanRenderGraph::allocateTransients()
+{
+	std::vector<RenderGraphResourceNode*> transients(m_TransientCount);
+	for (auto& node : m_Resources)
+		if (!node.imported)
+			transients[node.transientIndex] = &node;
+
+	// Everything placement depends on, the images are only recreated when it changes
+	std::string signature;
+	for (const RenderGraphResourceNode* node : transients)
+	{
+		char entry[128];
+		snprintf(entry, sizeof(entry), "%u,%u,%u,%u,%u,%u,%u;", (uint32_t)node->format, node->extent.width, node->extent.height,
+			(uint32_t)node->samples, (uint32_t)node->usage, node->firstUse, node->lastUse);
+		signature += entry;
+	}
+
+	if (signature != m_TransientSignature)
+	{
+		retireTransients();
+		m_TransientSignature = signature;
+
+		m_TransientImages.resize(transients.size());
+		m_TransientSlots.resize(transients.size());
+
+		std::vector<vk::MemoryRequirements> requirements(transients.size());
+		for (uint32_t i = 0; i < transients.size(); i++)
+		{
+			const RenderGraphResourceNode* node = transients[i];
+			if (node->firstUse == UINT32_MAX)
+				continue;
+
+			auto imageInfo = vk::ImageCreateInfo()
+				.setImageType(vk::ImageType::e2D)
+				.setFormat(node->format)
+				.setExtent(vk::Extent3D(node->extent.width, node->extent.height, 1))
+				.setMipLevels(1).setArrayLayers(1)
+				.setSamples(node->samples)
+				.setTiling(vk::ImageTiling::eOptimal)
+				.setUsage(node->usage)
+				.setSharingMode(vk::SharingMode::eExclusive)
+				.setInitialLayout(vk::ImageLayout::eUndefined);
+
+			m_TransientImages[i].image = m_VkDevice.createImage(imageInfo);
+			requirements[i] = m_VkDevice.getImageMemoryRequirements(m_TransientImages[i].image);
+		}
+
+		// Biggest images first, each one goes into the first slot whose current occupant is dead by the time it is first used
+		std::vector<uint32_t> placementOrder;
+		for (uint32_t i = 0; i < transients.size(); i++)
+			if (transients[i]->firstUse != UINT32_MAX)
+				placementOrder.push_back(i);
+		std::sort(placementOrder.begin(), placementOrder.end(), [&](uint32_t a, uint32_t b) { return requirements[a].size > requirements[b].size; });
+
+		std::vector<std::vector<uint32_t>> occupants;
+		for (uint32_t i : placementOrder)
+		{
+			const RenderGraphResourceNode* node = transients[i];
+
+			uint32_t slot = UINT32_MAX;
+			for (uint32_t s = 0; s < m_Slots.size() && slot == UINT32_MAX; s++)
+			{
+				if (!(m_Slots[s].requirements.memoryTypeBits & requirements[i].memoryTypeBits))
+					continue;
+
+				bool overlaps = false;
+				for (uint32_t other : occupants[s])
+					overlaps |= node->firstUse <= transients[other]->lastUse && transients[other]->firstUse <= node->lastUse;
+				if (!overlaps)
+					slot = s;
+			}
+
+			if (slot == UINT32_MAX)
+			{
+				slot = m_Slots.size();
+				m_Slots.emplace_back();
+				m_Slots[slot].requirements = requirements[i];
+				occupants.emplace_back();
+			}
+
+			vk::MemoryRequirements& slotRequirements = m_Slots[slot].requirements;
+			slotRequirements.size = std::max(slotRequirements.size, requirements[i].size);
+			slotRequirements.alignment = std::max(slotRequirements.alignment, requirements[i].alignment);
+			slotRequirements.memoryTypeBits &= requirements[i].memoryTypeBits;
+
+			occupants[slot].push_back(i);
+			m_TransientSlots[i] = slot;
+		}
+
+		for (uint32_t s = 0; s < m_Slots.size(); s++)
+		{
+			MemorySlot& slot = m_Slots[s];
+			slot.allocation = m_Device->getAllocator()->Allocate(slot.requirements, { {}, vk::MemoryPropertyFlagBits::eDeviceLocal }, true);
+			ASSERT(slot.allocation, "Failed to allocate %llu bytes for transient images", (unsigned long long)slot.requirements.size);
+
+			for (uint32_t i : occupants[s])
+			{
+				const RenderGraphResourceNode* node = transients[i];
+				m_VkDevice.bindImageMemory(m_TransientImages[i].image, slot.allocation.memory, slot.allocation.offset);
+
+				auto viewInfo = vk::ImageViewCreateInfo()
+					.setImage(m_TransientImages[i].image)
+					.setFormat(node->format)
+					.setViewType(vk::ImageViewType::e2D)
+					.setSubresourceRange({ node->aspect,0,1,0,1 });
+				m_TransientImages[i].view = m_VkDevice.createImageView(viewInfo);
+			}
+		}
+
+		LOG_TRACE("Render graph placed %u transient images in %u memory slots", (uint32_t)placementOrder.size(), (uint32_t)m_Slots.size());
+	}
+
+	for (auto& slot : m_Slots)
+	{
+		slot.stages = {};
+		slot.writeAccess = {};
+	}
+
+	for (RenderGraphResourceNode* node : transients)
+	{
+		node->image = m_TransientImages[node->transientIndex].image;
+		node->view = m_TransientImages[node->transientIndex].view;
+		if (node->firstUse == UINT32_MAX)
+			continue;
+
+		const uint32_t id = (uint32_t)(node - m_Resources.data());
+		for (uint32_t passIndex : m_Order)
+			for (const auto& access : m_Passes[passIndex].accesses)
+				if (access.resource == id)
+				{
+					MemorySlot& slot = m_Slots[m_TransientSlots[node->transientIndex]];
+					const UsageInfo info = GetUsageInfo(access.usage, access.write);
+					slot.stages |= info.stages;
+					if (access.write)
+						slot.writeAccess |= info.access;
+				}
+	}
+}
+
+void VulkanRenderGraph::buildBarriers()
+{
+	struct State
+	{
+		vk::ImageLayout layout;
+		// Last write not yet waited on by everyone, and the reads since then
+		vk::PipelineStageFlags writeStages;
+		vk::AccessFlags writeAccess;
+		vk::PipelineStageFlags readStages;
+		// Stages the last write is already visible to
+		vk::PipelineStageFlags visibleStages;
+	};
+
+	std::vector<State> states(m_Resources.size());
+	for (uint32_t i = 0; i < m_Resources.size(); i++)
+	{
+		const RenderGraphResourceNode& node = m_Resources[i];
+		State& state = states[i];
+
+		if (!node.isImage)
+		{
+			state.layout = vk::ImageLayout::eUndefined;
+		}
+		else if (node.imported)
+		{
+			state.layout = node.importInfo.initialLayout;
+			state.writeStages = node.importInfo.initialStages;
+			state.writeAccess = node.importInfo.initialAccess;
+		}
+		else
+		{
+			// Contents are discarded, but the uses of whatever shares the memory (this frame or the previous one) have to be done
+			// and its writes made available before the memory is written again
+			const MemorySlot& slot = m_Slots[m_TransientSlots[node.transientIndex]];
+			state.layout = vk::ImageLayout::eUndefined;
+			state.writeStages = slot.stages;
+			state.writeAccess = slot.writeAccess;
+		}
+	}
+
+	for (uint32_t position = 0; position < m_Order.size(); position++)
+	{
+		RenderGraphPass& pass = m_Passes[m_Order[position]];
+
+		std::vector<AttachmentKey> colorKeys, depthKeys;
+		std::vector<vk::ImageView> colorViews, depthViews;
+		std::vector<vk::ClearValue> colorClears, depthClears;
+
+		for (const auto& access : pass.accesses)
+		{
+			const RenderGraphResourceNode& node = m_Resources[access.resource];
+			const UsageInfo info = GetUsageInfo(access.usage, access.write);
+			State& state = states[access.resource];
+
+			bool layoutChange = node.isImage && state.layout != info.layout;
+
+			vk::PipelineStageFlags srcStages;
+			vk::AccessFlags srcAccess;
+			bool barrier = false;
+			if (access.write || layoutChange)
+			{
+				// Write after read only needs the reads to be done, write after write and layout changes need the writes available
+				srcStages = state.writeStages | state.readStages;
+				srcAccess = state.writeAccess;
+				barrier = srcStages || layoutChange;
+			}
+			else if (state.writeStages && (info.stages & ~state.visibleStages))
+			{
+				srcStages = state.writeStages;
+				srcAccess = state.writeAccess;
+				barrier = true;
+			}
+
+			if (info.attachment)
+			{
+				const bool depth = IsDepthLayout(info.layout);
+
+				AttachmentKey key;
+				key.format = node.format;
+				key.samples = node.samples;
+				key.layout = info.layout;
+				if (access.clear)
+					key.loadOp = vk::AttachmentLoadOp::eClear;
+				else if (state.layout == vk::ImageLayout::eUndefined)
+					key.loadOp = vk::AttachmentLoadOp::eDontCare;
+				else
+					key.loadOp = vk::AttachmentLoadOp::eLoad;
+				// Transients nobody uses after this pass don't need to be written back to memory
+				key.storeOp = (node.imported || node.lastUse > position) ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+
+				(depth ? depthKeys : colorKeys).push_back(key);
+				(depth ? depthViews : colorViews).push_back(node.view);
+				(depth ? depthClears : colorClears).push_back(access.clearValue);
+
+				if (pass.extent.width == 0)
+					pass.extent = node.extent;
+			}
+
+			if (barrier)
+			{
+				pass.srcStages |= srcStages ? srcStages : vk::PipelineStageFlagBits::eTopOfPipe;
+				pass.dstStages |= info.stages;
+
+				if (node.isImage)
+				{
+					// Cleared attachments don't care about what was there before
+					vk::ImageLayout oldLayout = (access.clear && access.write) ? vk::ImageLayout::eUndefined : state.layout;
+
+					pass.imageBarriers.push_back(vk::ImageMemoryBarrier()
+						.setSrcAccessMask(srcAccess).setDstAccessMask(info.access)
+						.setOldLayout(oldLayout).setNewLayout(info.layout)
+						.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED).setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+						.setImage(node.image)
+						.setSubresourceRange({ node.aspect,0,VK_REMAINING_MIP_LEVELS,0,VK_REMAINING_ARRAY_LAYERS }));
+				}
+				else
+				{
+					pass.memoryBarrier.srcAccessMask |= srcAccess;
+					pass.memoryBarrier.dstAccessMask |= info.access;
+				}
+			}
+
+			if (access.write)
+			{
+				state.writeStages = info.stages;
+				state.writeAccess = info.access;
+				state.readStages = {};
+				state.visibleStages = {};
+			}
+			else
+			{
+				state.readStages |= info.stages;
+				state.visibleStages |= info.stages;
+			}
+			if (node.isImage)
+				state.layout = info.layout;
+		}
+
+		if (colorKeys.size() || depthKeys.size())
+		{
+			std::vector<AttachmentKey> keys = colorKeys;
+			keys.insert(keys.end(), depthKeys.begin(), depthKeys.end());
+			std::vector<vk::ImageView> views = colorViews;
+			views.insert(views.end(), depthViews.begin(), depthViews.end());
+			pass.clearValues = colorClears;
+			pass.clearValues.insert(pass.clearValues.end(), depthClears.begin(), depthClears.end());
+
+			pass.renderPass = getRenderPass(keys);
+			pass.framebuffer = getFramebuffer(pass.renderPass, views, pass.extent);
+		}
+	}
+
+	// Outputs go to the layout they are expected in by whoever uses them after the graph (presentation, ...)
+	m_FinalSrcStages = {};
+	for (uint32_t i = 0; i < m_Resources.size(); i++)
+	{
+		const RenderGraphResourceNode& node = m_Resources[i];
+		const State& state = states[i];
+		if (!node.output || state.layout == node.importInfo.finalLayout)
+			continue;
+
+		m_FinalSrcStages |= state.writeStages | state.readStages;
+		m_FinalBarriers.push_back(vk::ImageMemoryBarrier()
+			.setSrcAccessMask(state.writeAccess).setDstAccessMask({})
+			.setOldLayout(state.layout).setNewLayout(node.importInfo.finalLayout)
+			.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED).setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+			.setImage(node.image)
+			.setSubresourceRange({ node.aspect,0,VK_REMAINING_MIP_LEVELS,0,VK_REMAINING_ARRAY_LAYERS }));
+	}
+	if (!m_FinalSrcStages)
+		m_FinalSrcStages = vk::PipelineStageFlagBits::eTopOfPipe;
+}
+
+vk::RenderPass VulkanRenderGraph::getRenderPass(const std::vector<AttachmentKey>& attachments)
+{
+	auto it = m_RenderPasses.find(attachments);
+	if (it != m_RenderPasses.end())
+		return it->second;
+
+	std::vector<vk::AttachmentDescription> descriptions;
+	std::vector<vk::AttachmentReference> colorRefs;
+	vk::AttachmentReference depthRef;
+	bool hasDepth = false;
+
+	for (uint32_t i = 0; i < attachments.size(); i++)
+	{
+		const AttachmentKey& key = attachments[i];
+
+		// The graph does the layout transitions with its barriers, the render pass stays in the attachment layout
+		descriptions.push_back(vk::AttachmentDescription()
+			.setFormat(key.format).setSamples(key.samples)
+			.setLoadOp(key.loadOp).setStoreOp(key.storeOp)
+			.setStencilLoadOp(key.loadOp).setStencilStoreOp(key.storeOp)
+			.setInitialLayout(key.layout).setFinalLayout(key.layout));
+
+		if (IsDepthLayout(key.layout))
+		{
+			depthRef = vk::AttachmentReference(i, key.layout);
+			hasDepth = true;
+		}
+		else
+		{
+			colorRefs.push_back(vk::AttachmentReference(i, key.layout));
+		}
+	}
+
+	auto subpass = vk::SubpassDescription()
+		.setPipelineBindPoint(vk::PipelineBindPoint::eGraphics)
+		.setColorAttachmentCount(colorRefs.size()).setPColorAttachments(colorRefs.data())
+		.setPDepthStencilAttachment(hasDepth ? &depthRef : nullptr);
+
+	auto passInfo = vk::RenderPassCreateInfo()
+		.setAttachmentCount(descriptions.size()).setPAttachments(descriptions.data())
+		.setSubpassCount(1).setPSubpasses(&subpass);
+
+	vk::RenderPass renderPass = m_VkDevice.createRenderPass(passInfo);
+	m_RenderPasses[attachments] = renderPass;
+	return renderPass;
+}
+
+vk::Framebuffer VulkanRenderGraph::getFramebuffer(vk::RenderPass renderPass, const std::vector<vk::ImageView>& views, vk::Extent2D extent)
+{
+	FramebufferKey key;
+	key.renderPass = renderPass;
+	for (vk::ImageView view : views)
+		key.views.push_back(view);
+	key.width = extent.width;
+	key.height = extent.height;
+
+	auto it = m_Framebuffers.find(key);
+	if (it != m_Framebuffers.end())
+		return it->second;
+
+	auto framebufferInfo = vk::FramebufferCreateInfo()
+		.setRenderPass(renderPass)
+		.setAttachmentCount(views.size()).setPAttachments(views.data())
+		.setWidth(extent.width).setHeight(extent.height).setLayers(1);
+
+	vk::Framebuffer framebuffer = m_VkDevice.createFramebuffer(framebufferInfo);
+	m_Framebuffers[key] = framebuffer;
+	return framebuffer;
+}
+
+void VulkanRenderGraph::retireTransients()
+{
+	Retired retired;
+	retired.frame = m_FrameNumber + m_FramesInFlight;
+	retired.images = std::move(m_TransientImages);
+	for (auto& slot : m_Slots)
+		retired.allocations.push_back(slot.allocation);
+
+	// Framebuffers of the old views can't be hit again, the views are destroyed with them
+	for (auto it = m_Framebuffers.begin(); it != m_Framebuffers.end();)
+	{
+		bool usesTransient = false;
+		for (const auto& image : retired.images)
+			usesTransient |= std::find(it->first.views.begin(), it->first.views.end(), (VkImageView)image.view) != it->first.views.end();
+
+		if (usesTransient)
+		{
+			retired.framebuffers.push_back(it->second);
+			it = m_Framebuffers.erase(it);
+		}
+		else
+			it++;
+	}
+
+	m_TransientImages.clear();
+	m_TransientSlots.clear();
+	m_Slots.clear();
+	m_TransientSignature.clear();
+
+	m_Retired.push_back(std::move(retired));
+}
+
+void VulkanRenderGraph::collect(bool all)
+{
+	auto it = std::remove_if(m_Retired.begin(), m_Retired.end(), [&](Retired& retired)
+		{
+			if (!all && retired.frame > m_FrameNumber)
+				return false;
+
+			for (const auto& framebuffer : retired.framebuffers)
+				m_VkDevice.destroyFramebuffer(framebuffer);
+			for (const auto& image : retired.images)
+			{
+				m_VkDevice.destroyImageView(image.view);
+				m_VkDevice.destroyImage(image.image);
+			}
+			for (auto& allocation : retired.allocations)
+				m_Device->getAllocator()->Free(allocation);
+			return true;
+		});
+	m_Retired.erase(it, m_Retired.end());
+}
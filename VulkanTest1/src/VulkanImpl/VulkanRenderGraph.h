@@ -0,0 +1,231 @@
+#pragma once
+
+#include "VulkanImpl/VulkanRenderDevice.h"
+#include "VulkanImpl/VulkanMemoryAllocator.h"
+#include "abstraction/Image.h"
+#include "abstraction/ImageView.h"
+#include "abstraction/Buffer.h"
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <map>
+#include <string>
+#include <functional>
+#include <tuple>
+
+// Handle to a resource of the graph being built, only valid until the next BeginFrame
+struct RenderGraphResource
+{
+	uint32_t id = UINT32_MAX;
+
+	inline bool IsValid() const { return id != UINT32_MAX; }
+};
+
+// How a pass touches a resource, each usage maps to the tightest stages/access/layout that cover it
+enum class RenderGraphUsage : uint8_t
+{
+	ColorAttachment,
+	DepthStencilAttachment,
+	SampledFragment,
+	SampledCompute,
+	StorageReadCompute,
+	StorageWriteCompute,
+	TransferSrc,
+	TransferDst,
+	VertexBuffer,
+	IndexBuffer,
+	UniformBuffer,
+	IndirectBuffer,
+};
+
+// An image living outside the graph, described by the state it is in when the frame's commands start
+struct RenderGraphImportedImage
+{
+	ImageView* view = nullptr;
+
+	vk::ImageLayout initialLayout = vk::ImageLayout::eUndefined;
+	// Work the first barrier has to wait for (nothing by default), for a swapchain image the stage its acquire semaphore is waited on
+	vk::PipelineStageFlags initialStages = {};
+	vk::AccessFlags initialAccess = {};
+
+	// eUndefined leaves the image in the layout of its last use, any other layout makes the image an output of the graph
+	vk::ImageLayout finalLayout = vk::ImageLayout::eUndefined;
+};
+
+// An image owned by the graph that only lives during the frame, transient images whose lifetimes don't overlap share memory
+struct RenderGraphImageDesc
+{
+	ImageFormat format = ImageFormat::RGBA8;
+	Dimensions2Du dimensions;
+	uint32_t samples = 1;
+};
+
+struct RenderGraphPassContext
+{
+	vk::CommandBuffer commandBuffer;
+
+	// Only set for passes with attachments, the render pass is already begun
+	vk::RenderPass renderPass;
+	vk::Framebuffer framebuffer;
+	vk::Extent2D extent;
+};
+
+struct RenderGraphPass;
+struct RenderGraphResourceNode;
+class VulkanGpuProfiler;
+
+/*
+	Frame graph on top of the device resources : every frame the passes are declared with the resources
+	they read and write, Compile() culls the passes that don't contribute to an output, orders them
+	and works out the barriers, Execute() records everything into a command buffer.
+	- the barriers of a pass are batched into a single pipelineBarrier with the stages of the actual previous
+	  and next uses instead of ALL_COMMANDS, read after read in the same layout needs no barrier at all
+	- passes with attachments get their render pass and framebuffer from a cache, the render passes have no
+	  layout transitions or dependencies of their own, load/store ops come from what happens before and after the pass
+	- transient images are placed in a few memory slots, images whose lifetimes don't overlap alias the same memory.
+	  They are shared by the frames in flight, the barriers order a frame's uses after the previous frame's
+
+	The graph is declared and recorded from one thread.
+*/
+class VulkanRenderGraph
+{
+public:
+	class PassBuilder
+	{
+	public:
+		void Read(RenderGraphResource resource, RenderGraphUsage usage);
+		void Write(RenderGraphResource resource, RenderGraphUsage usage);
+		// Attachments written with a clear value are cleared when the render pass begins
+		void Write(RenderGraphResource resource, RenderGraphUsage usage, const vk::ClearValue& clear);
+
+		// The render pass is begun with eSecondaryCommandBuffers, the pass only calls executeCommands
+		void UseSecondaryCommandBuffers();
+		// The pass is kept even when none of its writes are used (readbacks, ...)
+		void SetSideEffects();
+	private:
+		friend class VulkanRenderGraph;
+
+		PassBuilder(VulkanRenderGraph* graph, RenderGraphPass* pass)
+			:m_Graph(graph), m_Pass(pass)
+		{}
+		void access(RenderGraphResource resource, RenderGraphUsage usage, bool write, const vk::ClearValue* clear);
+	private:
+		VulkanRenderGraph* m_Graph;
+		RenderGraphPass* m_Pass;
+	};
+
+	using SetupFunction = std::function<void(PassBuilder& builder)>;
+	using ExecuteFunction = std::function<void(const RenderGraphPassContext& context)>;
+
+	VulkanRenderGraph(VulkanRenderDevice* device, uint32_t framesInFlight);
+	~VulkanRenderGraph();
+
+	// Forgets the passes of the previous frame, frameNumber is used to know when retired objects are no longer in use
+	void BeginFrame(uint64_t frameNumber);
+
+	RenderGraphResource ImportImage(const std::string& name, const RenderGraphImportedImage& image);
+	// Imported buffers are assumed to be done with by the previous frames' uses (uploads are ordered by the uploader)
+	RenderGraphResource ImportBuffer(const std::string& name, Buffer* buffer);
+	RenderGraphResource CreateImage(const std::string& name, const RenderGraphImageDesc& desc);
+
+	void AddPass(const std::string& name, const SetupFunction& setup, const ExecuteFunction& execute);
+
+	void Compile();
+	// With a profiler every pass is measured in a gpu scope named after it
+	void Execute(vk::CommandBuffer commandBuffer, VulkanGpuProfiler* profiler = nullptr);
+
+	// Valid between Compile() and the next BeginFrame
+	vk::ImageView GetImageView(RenderGraphResource resource) const;
+	vk::Buffer GetBuffer(RenderGraphResource resource) const;
+
+	// A render pass compatible with the ones the graph creates for these attachments, to create pipelines ahead of time
+	vk::RenderPass GetCompatibleRenderPass(const std::vector<ImageFormat>& colorFormats, ImageFormat depthFormat, bool hasDepth, uint32_t samples = 1);
+	// Framebuffers reference image views by handle, they have to be dropped when imported views are recreated (swapchain resize)
+	void ResetFramebuffers();
+
+	inline uint32_t GetCulledPassCount() const { return m_CulledPasses; }
+private:
+	struct AttachmentKey
+	{
+		vk::Format format;
+		vk::SampleCountFlagBits samples;
+		vk::AttachmentLoadOp loadOp;
+		vk::AttachmentStoreOp storeOp;
+		vk::ImageLayout layout;
+
+		inline bool operator<(const AttachmentKey& other) const
+		{
+			return std::tie(format, samples, loadOp, storeOp, layout) < std::tie(other.format, other.samples, other.loadOp, other.storeOp, other.layout);
+		}
+	};
+	struct FramebufferKey
+	{
+		VkRenderPass renderPass;
+		std::vector<VkImageView> views;
+		uint32_t width, height;
+
+		inline bool operator<(const FramebufferKey& other) const
+		{
+			return std::tie(renderPass, views, width, height) < std::tie(other.renderPass, other.views, other.width, other.height);
+		}
+	};
+	struct TransientImage
+	{
+		vk::Image image;
+		vk::ImageView view;
+	};
+	struct MemorySlot
+	{
+		VulkanAllocation allocation;
+		vk::MemoryRequirements requirements;
+		// Union of the stages of every image placed in the slot, what the first use of an image has to wait for
+		vk::PipelineStageFlags stages;
+		// Union of the writes to the slot, made available before the first use of an image
+		vk::AccessFlags writeAccess;
+	};
+	struct Retired
+	{
+		uint64_t frame;
+		std::vector<TransientImage> images;
+		std::vector<VulkanAllocation> allocations;
+		std::vector<vk::Framebuffer> framebuffers;
+	};
+
+	void cull();
+	void schedule();
+	void allocateTransients();
+	void buildBarriers();
+
+	vk::RenderPass getRenderPass(const std::vector<AttachmentKey>& attachments);
+	vk::Framebuffer getFramebuffer(vk::RenderPass renderPass, const std::vector<vk::ImageView>& views, vk::Extent2D extent);
+
+	void retireTransients();
+	void collect(bool all);
+private:
+	VulkanRenderDevice* m_Device;
+	vk::Device m_VkDevice;
+	uint32_t m_FramesInFlight;
+	uint64_t m_FrameNumber = 0;
+
+	// Rebuilt every frame
+	std::vector<RenderGraphResourceNode> m_Resources;
+	std::vector<RenderGraphPass> m_Passes;
+	std::vector<uint32_t> m_Order;
+	uint32_t m_TransientCount = 0;
+	uint32_t m_CulledPasses = 0;
+	bool m_Compiled = false;
+
+	std::vector<vk::ImageMemoryBarrier> m_FinalBarriers;
+	vk::PipelineStageFlags m_FinalSrcStages;
+
+	// Kept across frames while the transient images stay the same
+	std::string m_TransientSignature;
+	std::vector<TransientImage> m_TransientImages;
+	std::vector<uint32_t> m_TransientSlots;
+	std::vector<MemorySlot> m_Slots;
+
+	std::map<std::vector<AttachmentKey>, vk::RenderPass> m_RenderPasses;
+	// Only dropped with the views they reference (ResetFramebuffers, retireTransients), swapchain images come back every imageCount frames
+	std::map<FramebufferKey, vk::Framebuffer> m_Framebuffers;
+
+	std::vector<Retired> m_Retired;
+};
@@ -2,8 +2,22 @@
 #include "VulkanRenderInstance.h"
 #include "VulkanRenderDevice.h"
 
+// Called from whatever thread made the call being validated, the logger doesn't block it.
+// Verbose and info messages (loader chatter) are dropped
 VKAPI_ATTR VkBool32 VKAPI_CALL DebugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* pUserData)
 {
+	switch (messageSeverity)
+	{
+	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
+		LOG_WARN("[Validation layer] Warning : %s\n%s", pCallbackData->pMessageIdName, pCallbackData->pMessage);
+		break;
+	case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
+		LOG_ERROR("[Validation layer] Error : %s\n%s", pCallbackData->pMessageIdName, pCallbackData->pMessage);
+		break;
+	default:
+		break;
+	}
+
 	return VK_FALSE;
 }
 
@@ -18,7 +32,7 @@ static inline vk::DebugUtilsMessengerCreateInfoEXT GetMessengerInfo()
 		.setPfnUserCallback(DebugCallback);
 }
 
-VulkanRenderInstance::VulkanRenderInstance(bool debug)
+VulkanRenderInstance::VulkanRenderInstance(bool debug, bool headless)
 	:m_DebugEnabled(debug)
 {
 	vk::ApplicationInfo appInfo = { 
@@ -27,9 +41,15 @@ VulkanRenderInstance::VulkanRenderInstance(bool debug)
 									VK_API_VERSION_1_1
 								  };
 
-	uint32_t count;
-	const char** glfwExt = glfwGetRequiredInstanceExtensions(&count);
-	std::vector<const char*> extensions(glfwExt, glfwExt + count);
+	// GLFW doesn't have to be initialized at all when running headless
+	std::vector<const char*> extensions;
+	if (!headless)
+	{
+		uint32_t count;
+		const char** glfwExt = glfwGetRequiredInstanceExtensions(&count);
+		ASSERT(glfwExt, "No window system extensions available for Vulkan");
+		extensions.assign(glfwExt, glfwExt + count);
+	}
 	std::vector<const char*> layers;
 
 	if (m_DebugEnabled)
@@ -66,7 +86,7 @@ VulkanRenderInstance::~VulkanRenderInstance()
 
 RenderDevice* VulkanRenderInstance::CreateDevice(const RenderDeviceDesc& desc) const
 {
-	return new VulkanRenderDevice(m_Instance.enumeratePhysicalDevices(), desc.window ? createSurface(desc.window) : vk::SurfaceKHR(nullptr),desc.window, desc.useGraphics, desc.useCompute);
+	return new VulkanRenderDevice(m_Instance, m_Instance.enumeratePhysicalDevices(), desc.window ? createSurface(desc.window) : vk::SurfaceKHR(nullptr), desc);
 }
 
 
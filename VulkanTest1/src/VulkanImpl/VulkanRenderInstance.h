@@ -6,7 +6,7 @@
 class VulkanRenderInstance : public RenderInstance
 {
 public:
-	VulkanRenderInstance(bool debug);
+	VulkanRenderInstance(bool debug, bool headless = false);
 	~VulkanRenderInstance();
 
 	virtual RenderDevice* CreateDevice(const RenderDeviceDesc& desc) const override;
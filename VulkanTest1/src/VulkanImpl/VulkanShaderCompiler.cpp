@@ -0,0 +1,223 @@
+#include "pch.h"
+#include "VulkanShaderCompiler.h"
+#include "Tracing.h"
+#include "Utils.h"
+#include <shaderc/shaderc.hpp>
+#include <filesystem>
+#include <sstream>
+
+static constexpr uint32_t SpirvMagic = 0x07230203;
+
+inline static uint64_t HashString(const std::string& text, uint64_t hash)
+{
+	// The length goes in too so that "ab"+"c" and "a"+"bc" differ
+	const uint64_t size = text.size();
+	hash = Fnv1a(&size, sizeof(size), hash);
+	return Fnv1a(text.data(), text.size(), hash);
+}
+
+static bool GetShaderKind(const std::string& path, shaderc_shader_kind& kind)
+{
+	const std::string extension = std::filesystem::path(path).extension().string();
+
+	if (extension == ".vert")		kind = shaderc_vertex_shader;
+	else if (extension == ".frag")	kind = shaderc_fragment_shader;
+	else if (extension == ".comp")	kind = shaderc_compute_shader;
+	else if (extension == ".geom")	kind = shaderc_geometry_shader;
+	else if (extension == ".tesc")	kind = shaderc_tess_control_shader;
+	else if (extension == ".tese")	kind = shaderc_tess_evaluation_shader;
+	else return false;
+
+	return true;
+}
+
+static bool ReadText(const std::string& path, std::string& text)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	std::stringstream stream;
+	stream << file.rdbuf();
+	text = stream.str();
+	return true;
+}
+
+// #include "x" is looked up next to the including file, #include <x> next to the root shader
+class ShaderIncluder : public shaderc::CompileOptions::IncluderInterface
+{
+public:
+	ShaderIncluder(const std::string& rootPath)
+		:m_RootDirectory(std::filesystem::path(rootPath).parent_path())
+	{}
+
+	virtual shaderc_include_result* GetInclude(const char* requestedSource, shaderc_include_type type, const char* requestingSource, size_t includeDepth) override
+	{
+		const std::filesystem::path directory = type == shaderc_include_type_relative ? std::filesystem::path(requestingSource).parent_path() : m_RootDirectory;
+
+		// Owns the strings the result points to
+		auto* include = new std::pair<std::string, std::string>();
+		include->first = (directory / requestedSource).lexically_normal().string();
+		if (!ReadText(include->first, include->second))
+		{
+			include->second = "Can't open include file \"" + include->first + "\"";
+			include->first.clear();
+		}
+
+		auto* result = new shaderc_include_result();
+		result->source_name = include->first.c_str();
+		result->source_name_length = include->first.size();
+		result->content = include->second.c_str();
+		result->content_length = include->second.size();
+		result->user_data = include;
+		return result;
+	}
+
+	virtual void ReleaseInclude(shaderc_include_result* data) override
+	{
+		delete (std::pair<std::string, std::string>*)data->user_data;
+		delete data;
+	}
+private:
+	std::filesystem::path m_RootDirectory;
+};
+
+VulkanShaderCompiler::VulkanShaderCompiler(const std::string& cacheDirectory, ThreadPool* threadPool)
+	:m_CacheDirectory(cacheDirectory), m_ThreadPool(threadPool), m_Compiler(new shaderc::Compiler())
+{
+	ASSERT(m_Compiler->IsValid(), "Failed to initialize shaderc");
+
+	unsigned int version, revision;
+	shaderc_get_spv_version(&version, &revision);
+	m_SpirvVersion = version;
+
+	std::error_code error;
+	std::filesystem::create_directories(m_CacheDirectory, error);
+	if (error)
+		LOG_WARN("Can't create the shader cache directory \"%s\" : %s", m_CacheDirectory.c_str(), error.message().c_str());
+}
+
+VulkanShaderCompiler::~VulkanShaderCompiler()
+{
+	delete m_Compiler;
+}
+
+std::vector<uint32_t> VulkanShaderCompiler::Compile(const ShaderCompileDesc& desc)
+{
+	TRACE_ZONE("Compile shader");
+
+	shaderc_shader_kind kind;
+	if (!GetShaderKind(desc.path, kind))
+	{
+		LOG_ERROR("Unknown shader stage for \"%s\"", desc.path.c_str());
+		return {};
+	}
+
+	std::string source;
+	if (!ReadText(desc.path, source))
+	{
+		LOG_ERROR("Failed to open the shader \"%s\"", desc.path.c_str());
+		return {};
+	}
+
+	shaderc::CompileOptions options;
+	options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_1);
+	options.SetOptimizationLevel(desc.optimize ? shaderc_optimization_level_performance : shaderc_optimization_level_zero);
+	if (desc.debugInfo)
+		options.SetGenerateDebugInfo();
+	for (const auto& [name, value] : desc.defines)
+		options.AddMacroDefinition(name, value);
+	options.SetIncluder(std::make_unique<ShaderIncluder>(desc.path));
+
+	auto preprocessed = m_Compiler->PreprocessGlsl(source.data(), source.size(), kind, desc.path.c_str(), options);
+	if (preprocessed.GetCompilationStatus() != shaderc_compilation_status_success)
+	{
+		LOG_ERROR("Failed to preprocess \"%s\" :\n%s", desc.path.c_str(), preprocessed.GetErrorMessage().c_str());
+		return {};
+	}
+	const std::string text(preprocessed.cbegin(), preprocessed.cend());
+
+	// Includes and defines are already part of the text, they are hashed anyway in case a define is only used by #if
+	uint64_t hash = HashString(text, 0xcbf29ce484222325ull);
+	for (const auto& [name, value] : desc.defines)
+		hash = HashString(value, HashString(name, hash));
+	const uint64_t flags = ((uint64_t)kind << 32) | ((uint64_t)desc.optimize << 1) | (uint64_t)desc.debugInfo;
+	hash = Fnv1a(&flags, sizeof(flags), hash);
+	hash = Fnv1a(&m_SpirvVersion, sizeof(m_SpirvVersion), hash);
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.spv", (unsigned long long)hash);
+	const std::string cachePath = (std::filesystem::path(m_CacheDirectory) / name).string();
+
+	std::vector<uint32_t> code = loadCached(cachePath);
+	if (code.size())
+	{
+		m_CacheHits++;
+		return code;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	// The original source rather than the preprocessed text, the errors point into the right files
+	auto result = m_Compiler->CompileGlslToSpv(source.data(), source.size(), kind, desc.path.c_str(), "main", options);
+	if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+	{
+		LOG_ERROR("Failed to compile \"%s\" :\n%s", desc.path.c_str(), result.GetErrorMessage().c_str());
+		return {};
+	}
+	if (result.GetNumWarnings())
+		LOG_WARN("\"%s\" :\n%s", desc.path.c_str(), result.GetErrorMessage().c_str());
+
+	code.assign(result.cbegin(), result.cend());
+	LOG_INFO("Compiled \"%s\" in %.2f ms", desc.path.c_str(), std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+	storeCached(cachePath, code);
+	return code;
+}
+
+std::vector<std::vector<uint32_t>> VulkanShaderCompiler::CompileAll(const std::vector<ShaderCompileDesc>& descs)
+{
+	std::vector<std::vector<uint32_t>> results(descs.size());
+
+	if (!m_ThreadPool)
+	{
+		for (size_t i = 0; i < descs.size(); i++)
+			results[i] = Compile(descs[i]);
+		return results;
+	}
+
+	m_ThreadPool->ParallelFor((uint32_t)descs.size(), [&](uint32_t i, uint32_t threadIndex)
+		{
+			results[i] = Compile(descs[i]);
+		});
+	return results;
+}
+
+std::vector<uint32_t> VulkanShaderCompiler::loadCached(const std::string& path) const
+{
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+	if (!file)
+		return {};
+
+	const size_t size = (size_t)file.tellg();
+	if (size < sizeof(uint32_t) || size % sizeof(uint32_t))
+		return {};
+
+	std::vector<uint32_t> code(size / sizeof(uint32_t));
+	file.seekg(0);
+	file.read((char*)code.data(), size);
+
+	if (!file || code[0] != SpirvMagic)
+	{
+		LOG_WARN("Ignoring the invalid cached shader \"%s\"", path.c_str());
+		return {};
+	}
+	return code;
+}
+
+void VulkanShaderCompiler::storeCached(const std::string& path, const std::vector<uint32_t>& code) const
+{
+	// Another thread may be writing the same entry, ReplaceFile gives each its own temporary file
+	std::string error;
+	if (!ReplaceFile(path, { { code.data(), code.size() * sizeof(uint32_t) } }, error))
+		LOG_WARN("Failed to write the cached shader \"%s\" : %s", path.c_str(), error.c_str());
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include <vector>
+#include <string>
+#include <utility>
+#include <atomic>
+#include <stdint.h>
+
+namespace shaderc { class Compiler; }
+
+struct ShaderCompileDesc
+{
+	// GLSL file, the stage comes from the extension (.vert, .frag, .comp, .geom, .tesc, .tese)
+	std::string path;
+	std::vector<std::pair<std::string, std::string>> defines;
+	bool optimize = true;
+	bool debugInfo = false;
+};
+
+/*
+	Compiles GLSL to SPIR-V at runtime with shaderc.
+	The source is preprocessed first (includes resolved relative to the including file, defines applied),
+	the preprocessed text, the options and the compiler's SPIR-V version are hashed into the name of the cache file.
+	Warm starts only pay for the preprocessing, edited includes or defines give another key.
+	Cache files are written to a temporary file then renamed, concurrent runs never see partial files.
+	Compile() can be called from several threads.
+*/
+class VulkanShaderCompiler
+{
+public:
+	VulkanShaderCompiler(const std::string& cacheDirectory, ThreadPool* threadPool = nullptr);
+	~VulkanShaderCompiler();
+
+	// Returns an empty vector and logs the errors when the shader doesn't compile
+	std::vector<uint32_t> Compile(const ShaderCompileDesc& desc);
+	// Compiles on the thread pool's workers, results in the order of descs
+	std::vector<std::vector<uint32_t>> CompileAll(const std::vector<ShaderCompileDesc>& descs);
+
+	inline uint32_t GetCacheHits() const { return m_CacheHits; }
+private:
+	std::vector<uint32_t> loadCached(const std::string& path) const;
+	void storeCached(const std::string& path, const std::vector<uint32_t>& code) const;
+private:
+	std::string m_CacheDirectory;
+	ThreadPool* m_ThreadPool;
+
+	shaderc::Compiler* m_Compiler;
+	uint32_t m_SpirvVersion;
+	std::atomic<uint32_t> m_CacheHits{ 0 };
+};
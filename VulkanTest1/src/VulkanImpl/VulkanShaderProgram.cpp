@@ -0,0 +1,290 @@
+#include "pch.h"
+#include "VulkanShaderProgram.h"
+#include "VulkanLayoutCache.h"
+#include <spirv_cross/spirv_cross.hpp>
+
+static vk::ShaderStageFlagBits GetStage(spv::ExecutionModel model)
+{
+	switch (model)
+	{
+	case spv::ExecutionModelVertex:						return vk::ShaderStageFlagBits::eVertex;
+	case spv::ExecutionModelTessellationControl:		return vk::ShaderStageFlagBits::eTessellationControl;
+	case spv::ExecutionModelTessellationEvaluation:		return vk::ShaderStageFlagBits::eTessellationEvaluation;
+	case spv::ExecutionModelGeometry:					return vk::ShaderStageFlagBits::eGeometry;
+	case spv::ExecutionModelFragment:					return vk::ShaderStageFlagBits::eFragment;
+	case spv::ExecutionModelGLCompute:					return vk::ShaderStageFlagBits::eCompute;
+	default:
+		ASSERT(false, "Unsupported shader execution model %u", (uint32_t)model);
+		return {};
+	}
+}
+
+// Format of one column, matrices are fed column by column
+static vk::Format GetVertexFormat(const spirv_cross::SPIRType& type)
+{
+	constexpr vk::Format floats[] = { vk::Format::eR32Sfloat, vk::Format::eR32G32Sfloat, vk::Format::eR32G32B32Sfloat, vk::Format::eR32G32B32A32Sfloat };
+	constexpr vk::Format ints[] = { vk::Format::eR32Sint, vk::Format::eR32G32Sint, vk::Format::eR32G32B32Sint, vk::Format::eR32G32B32A32Sint };
+	constexpr vk::Format uints[] = { vk::Format::eR32Uint, vk::Format::eR32G32Uint, vk::Format::eR32G32B32Uint, vk::Format::eR32G32B32A32Uint };
+
+	switch (type.basetype)
+	{
+	case spirv_cross::SPIRType::Float:	return floats[type.vecsize - 1];
+	case spirv_cross::SPIRType::Int:	return ints[type.vecsize - 1];
+	case spirv_cross::SPIRType::UInt:	return uints[type.vecsize - 1];
+	default:
+		ASSERT(false, "Unsupported vertex input type %u", (uint32_t)type.basetype);
+		return vk::Format::eUndefined;
+	}
+}
+
+static uint32_t GetFormatSize(vk::Format format)
+{
+	switch (format)
+	{
+	case vk::Format::eR8G8B8A8Unorm: case vk::Format::eR8G8B8A8Snorm: case vk::Format::eR8G8B8A8Uint: case vk::Format::eR8G8B8A8Sint:
+	case vk::Format::eR16G16Sfloat: case vk::Format::eR16G16Unorm: case vk::Format::eR16G16Snorm:
+	case vk::Format::eR32Sfloat: case vk::Format::eR32Sint: case vk::Format::eR32Uint:
+		return 4;
+	case vk::Format::eR16G16B16A16Sfloat: case vk::Format::eR16G16B16A16Unorm: case vk::Format::eR16G16B16A16Snorm:
+	case vk::Format::eR32G32Sfloat: case vk::Format::eR32G32Sint: case vk::Format::eR32G32Uint:
+		return 8;
+	case vk::Format::eR32G32B32Sfloat: case vk::Format::eR32G32B32Sint: case vk::Format::eR32G32B32Uint:
+		return 12;
+	case vk::Format::eR32G32B32A32Sfloat: case vk::Format::eR32G32B32A32Sint: case vk::Format::eR32G32B32A32Uint:
+		return 16;
+	default:
+		ASSERT(false, "Unsupported vertex format %s", vk::to_string(format).c_str());
+		return 0;
+	}
+}
+
+VulkanShaderProgram::VulkanShaderProgram(VulkanRenderDevice* device, const VulkanShaderProgramDesc& desc)
+	:m_Device(device->getDevice()), m_DynamicBuffers(desc.dynamicBuffers), m_ExternalSets(desc.externalSets)
+{
+	ASSERT(desc.stages.size(), "A shader program needs at least one stage");
+
+	for (const auto& code : desc.stages)
+	{
+		vk::ShaderStageFlagBits stage;
+		reflect(code, stage);
+		ASSERT(!(m_StageFlags & stage), "The program has two %s stages", vk::to_string(stage).c_str());
+		m_StageFlags |= stage;
+
+		vk::ShaderModule module = m_Device.createShaderModule(vk::ShaderModuleCreateInfo()
+			.setCodeSize(code.size() * sizeof(uint32_t))
+			.setPCode(code.data()));
+
+		m_Modules.push_back(module);
+		m_Stages.push_back(vk::PipelineShaderStageCreateInfo()
+			.setStage(stage)
+			.setModule(module)
+			.setPName("main"));
+	}
+
+	// Sets are indexed by number in the pipeline layout, the ones no stage uses get an empty layout
+	VulkanLayoutCache* cache = device->getLayoutCache();
+	uint32_t setCount = m_Bindings.empty() ? 0 : m_Bindings.rbegin()->first + 1;
+	if (!m_ExternalSets.empty())
+		setCount = std::max(setCount, m_ExternalSets.rbegin()->first + 1);
+	for (uint32_t set = 0; set < setCount; set++)
+	{
+		auto external = m_ExternalSets.find(set);
+		if (external != m_ExternalSets.end())
+		{
+			m_SetLayouts.push_back(external->second);
+			continue;
+		}
+
+		std::vector<vk::DescriptorSetLayoutBinding> bindings;
+		for (const auto& [index, binding] : m_Bindings[set])
+		{
+			ASSERT(binding.descriptorCount, "Binding %u of set %u is a runtime sized array, its set must be external", index, set);
+			bindings.push_back(binding);
+		}
+
+		m_SetLayouts.push_back(cache->GetDescriptorSetLayout(bindings));
+	}
+
+	if (m_PushConstantStages)
+	{
+		// Only 128 bytes are guaranteed
+		const uint32_t maxSize = device->getLimits().maxPushConstantsSize;
+		ASSERT(m_PushConstantEnd <= maxSize, "The push constants end at %u bytes, the device only has %u", m_PushConstantEnd, maxSize);
+		m_PushConstants.push_back({ m_PushConstantStages, m_PushConstantBegin, m_PushConstantEnd - m_PushConstantBegin });
+	}
+
+	m_PipelineLayout = cache->GetPipelineLayout(m_SetLayouts, m_PushConstants);
+
+	buildVertexInput(desc.vertexFormats, desc.firstInstanceLocation);
+}
+
+VulkanShaderProgram::~VulkanShaderProgram()
+{
+	for (auto module : m_Modules)
+		m_Device.destroyShaderModule(module);
+}
+
+std::vector<uint32_t> VulkanShaderProgram::LoadSpirv(const std::string& path)
+{
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+	ASSERT(file.is_open(), "Failed to open the shader \"%s\"", path.c_str());
+
+	const size_t size = (size_t)file.tellg();
+	ASSERT(size % sizeof(uint32_t) == 0, "\"%s\" is not SPIR-V", path.c_str());
+
+	std::vector<uint32_t> code(size / sizeof(uint32_t));
+	file.seekg(0);
+	file.read((char*)code.data(), size);
+
+	return code;
+}
+
+std::vector<vk::DescriptorPoolSize> VulkanShaderProgram::GetPoolSizes() const
+{
+	std::map<vk::DescriptorType, uint32_t> counts;
+	for (const auto& [set, bindings] : m_Bindings)
+	{
+		if (m_ExternalSets.count(set))
+			continue;
+		for (const auto& [index, binding] : bindings)
+			counts[binding.descriptorType] += binding.descriptorCount;
+	}
+
+	std::vector<vk::DescriptorPoolSize> sizes;
+	for (const auto& [type, count] : counts)
+		sizes.push_back({ type, count });
+	return sizes;
+}
+
+void VulkanShaderProgram::reflect(const std::vector<uint32_t>& code, vk::ShaderStageFlagBits& stage)
+{
+	try
+	{
+		spirv_cross::Compiler compiler(code);
+		stage = GetStage(compiler.get_execution_model());
+
+		const spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+
+		auto addResources = [&](const spirv_cross::SmallVector<spirv_cross::Resource>& list, vk::DescriptorType type)
+		{
+			for (const auto& resource : list)
+			{
+				const spirv_cross::SPIRType& spirType = compiler.get_type(resource.type_id);
+
+				// 0 for runtime sized arrays
+				uint32_t count = 1;
+				for (uint32_t size : spirType.array)
+					count *= size;
+
+				// Buffer images are texel buffers
+				vk::DescriptorType actualType = type;
+				if (spirType.basetype == spirv_cross::SPIRType::Image || spirType.basetype == spirv_cross::SPIRType::SampledImage)
+				{
+					if (spirType.image.dim == spv::DimBuffer)
+						actualType = type == vk::DescriptorType::eStorageImage ? vk::DescriptorType::eStorageTexelBuffer : vk::DescriptorType::eUniformTexelBuffer;
+				}
+
+				const uint32_t set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+				addBinding(set, vk::DescriptorSetLayoutBinding()
+					.setBinding(compiler.get_decoration(resource.id, spv::DecorationBinding))
+					.setDescriptorType(actualType)
+					.setDescriptorCount(count)
+					.setStageFlags(stage));
+			}
+		};
+
+		addResources(resources.uniform_buffers, vk::DescriptorType::eUniformBuffer);
+		addResources(resources.storage_buffers, vk::DescriptorType::eStorageBuffer);
+		addResources(resources.sampled_images, vk::DescriptorType::eCombinedImageSampler);
+		addResources(resources.separate_images, vk::DescriptorType::eSampledImage);
+		addResources(resources.separate_samplers, vk::DescriptorType::eSampler);
+		addResources(resources.storage_images, vk::DescriptorType::eStorageImage);
+		addResources(resources.subpass_inputs, vk::DescriptorType::eInputAttachment);
+
+		for (const auto& resource : resources.push_constant_buffers)
+		{
+			const spirv_cross::SPIRType& type = compiler.get_type(resource.base_type_id);
+
+			uint32_t begin = UINT32_MAX;
+			for (uint32_t i = 0; i < type.member_types.size(); i++)
+				begin = std::min(begin, compiler.type_struct_member_offset(type, i));
+
+			m_PushConstantBegin = std::min(m_PushConstantBegin, begin);
+			m_PushConstantEnd = std::max(m_PushConstantEnd, (uint32_t)compiler.get_declared_struct_size(type));
+			m_PushConstantStages |= stage;
+		}
+
+		if (stage == vk::ShaderStageFlagBits::eVertex)
+		{
+			for (const auto& resource : resources.stage_inputs)
+			{
+				if (compiler.has_decoration(resource.id, spv::DecorationBuiltIn))
+					continue;
+
+				const uint32_t location = compiler.get_decoration(resource.id, spv::DecorationLocation);
+				const spirv_cross::SPIRType& type = compiler.get_type(resource.type_id);
+				for (uint32_t column = 0; column < type.columns; column++)
+					m_VertexInputs[location + column] = GetVertexFormat(type);
+			}
+		}
+	}
+	catch (const spirv_cross::CompilerError& error)
+	{
+		ASSERT(false, "SPIR-V reflection failed : %s", error.what());
+	}
+}
+
+void VulkanShaderProgram::addBinding(uint32_t set, const vk::DescriptorSetLayoutBinding& binding)
+{
+	vk::DescriptorSetLayoutBinding reflected = binding;
+
+	const bool dynamic = std::find(m_DynamicBuffers.begin(), m_DynamicBuffers.end(), std::make_pair(set, binding.binding)) != m_DynamicBuffers.end();
+	if (dynamic && reflected.descriptorType == vk::DescriptorType::eUniformBuffer)
+		reflected.descriptorType = vk::DescriptorType::eUniformBufferDynamic;
+	else if (dynamic && reflected.descriptorType == vk::DescriptorType::eStorageBuffer)
+		reflected.descriptorType = vk::DescriptorType::eStorageBufferDynamic;
+	else
+		ASSERT(!dynamic, "Binding %u of set %u is not a buffer, it can't be dynamic", binding.binding, set);
+
+	auto& bindings = m_Bindings[set];
+	auto it = bindings.find(binding.binding);
+	if (it == bindings.end())
+	{
+		bindings[binding.binding] = reflected;
+		return;
+	}
+
+	// Declared by several stages, the declarations must agree
+	ASSERT(it->second.descriptorType == reflected.descriptorType && it->second.descriptorCount == reflected.descriptorCount,
+		"Binding %u of set %u is declared differently by two stages", binding.binding, set);
+	it->second.stageFlags |= reflected.stageFlags;
+}
+
+void VulkanShaderProgram::buildVertexInput(const std::map<uint32_t, vk::Format>& overrides, uint32_t firstInstanceLocation)
+{
+	// Locations are in order, every input of a binding follows the previous one
+	for (const auto& [location, shaderFormat] : m_VertexInputs)
+	{
+		auto it = overrides.find(location);
+		const vk::Format format = it != overrides.end() ? it->second : shaderFormat;
+		const uint32_t binding = location >= firstInstanceLocation ? 1 : 0;
+
+		m_VertexAttributes.push_back(vk::VertexInputAttributeDescription()
+			.setBinding(binding)
+			.setLocation(location)
+			.setFormat(format)
+			.setOffset(m_VertexStrides[binding]));
+		m_VertexStrides[binding] += GetFormatSize(format);
+	}
+
+	constexpr std::array<vk::VertexInputRate, 2> rates = { vk::VertexInputRate::eVertex, vk::VertexInputRate::eInstance };
+	for (uint32_t binding = 0; binding < 2; binding++)
+	{
+		if (m_VertexStrides[binding])
+			m_VertexBindings.push_back({ binding, m_VertexStrides[binding], rates[binding] });
+	}
+
+	m_VertexInputState = vk::PipelineVertexInputStateCreateInfo()
+		.setVertexBindingDescriptionCount(m_VertexBindings.size()).setPVertexBindingDescriptions(m_VertexBindings.data())
+		.setVertexAttributeDescriptionCount(m_VertexAttributes.size()).setPVertexAttributeDescriptions(m_VertexAttributes.data());
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "VulkanImpl/VulkanRenderDevice.h"
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <array>
+#include <map>
+#include <string>
+
+struct VulkanShaderProgramDesc
+{
+	// SPIR-V of every stage, the stage is read from the module's entry point
+	std::vector<std::vector<uint32_t>> stages;
+
+	// {set, binding} of the buffers bound with dynamic offsets, nothing in SPIR-V tells them apart
+	std::vector<std::pair<uint32_t, uint32_t>> dynamicBuffers;
+	// Vertex buffer formats that differ from the shader inputs, by location (a vec4 input fed with two floats)
+	std::map<uint32_t, vk::Format> vertexFormats;
+	// Inputs at this location and above are read per instance from binding 1, a matrix input takes one location per column
+	uint32_t firstInstanceLocation = UINT32_MAX;
+	// Sets whose layout is made elsewhere (the bindless heap), used as is instead of the reflected one.
+	// Runtime sized arrays (textures[]) are only allowed in them
+	std::map<uint32_t, vk::DescriptorSetLayout> externalSets;
+};
+
+/*
+	A set of shader modules and everything a pipeline needs to know about their interface, reflected from SPIR-V :
+	descriptor set layouts, push constant ranges and vertex input.
+	Bindings used by several stages are merged, push constants become a single range visible to every stage using it.
+	Vertex attributes are interleaved in binding 0, in location order and tightly packed, the per instance ones the same way in binding 1.
+	The layouts come from the device's layout cache, programs with the same interface share them.
+*/
+class VulkanShaderProgram
+{
+public:
+	VulkanShaderProgram(VulkanRenderDevice* device, const VulkanShaderProgramDesc& desc);
+	~VulkanShaderProgram();
+
+	static std::vector<uint32_t> LoadSpirv(const std::string& path);
+
+	// Pool sizes to allocate one set of each layout, external sets excluded
+	std::vector<vk::DescriptorPoolSize> GetPoolSizes() const;
+public:
+	inline const std::vector<vk::PipelineShaderStageCreateInfo>& getStages() const { return m_Stages; }
+	// Points into the program, only valid while it lives
+	inline const vk::PipelineVertexInputStateCreateInfo& getVertexInputState() const { return m_VertexInputState; }
+	inline uint32_t getVertexStride() const { return m_VertexStrides[0]; }
+	// 0 without per instance inputs
+	inline uint32_t getInstanceStride() const { return m_VertexStrides[1]; }
+	inline vk::PipelineLayout getPipelineLayout() const { return m_PipelineLayout; }
+	inline const std::vector<vk::DescriptorSetLayout>& getSetLayouts() const { return m_SetLayouts; }
+	inline const std::vector<vk::PushConstantRange>& getPushConstantRanges() const { return m_PushConstants; }
+	inline vk::ShaderStageFlags getStageFlags() const { return m_StageFlags; }
+private:
+	void reflect(const std::vector<uint32_t>& code, vk::ShaderStageFlagBits& stage);
+	void addBinding(uint32_t set, const vk::DescriptorSetLayoutBinding& binding);
+	void buildVertexInput(const std::map<uint32_t, vk::Format>& overrides, uint32_t firstInstanceLocation);
+private:
+	vk::Device m_Device;
+	vk::ShaderStageFlags m_StageFlags;
+
+	std::vector<vk::ShaderModule> m_Modules;
+	std::vector<vk::PipelineShaderStageCreateInfo> m_Stages;
+
+	// Reflection results, [set][binding]
+	std::map<uint32_t, std::map<uint32_t, vk::DescriptorSetLayoutBinding>> m_Bindings;
+	std::vector<std::pair<uint32_t, uint32_t>> m_DynamicBuffers;
+	std::map<uint32_t, vk::DescriptorSetLayout> m_ExternalSets;
+	std::map<uint32_t, vk::Format> m_VertexInputs;
+	uint32_t m_PushConstantBegin = UINT32_MAX, m_PushConstantEnd = 0;
+	vk::ShaderStageFlags m_PushConstantStages;
+
+	std::vector<vk::DescriptorSetLayout> m_SetLayouts;
+	std::vector<vk::PushConstantRange> m_PushConstants;
+	vk::PipelineLayout m_PipelineLayout;
+
+	std::array<uint32_t, 2> m_VertexStrides = {};
+	std::vector<vk::VertexInputBindingDescription> m_VertexBindings;
+	std::vector<vk::VertexInputAttributeDescription> m_VertexAttributes;
+	vk::PipelineVertexInputStateCreateInfo m_VertexInputState;
+};
@@ -7,39 +7,36 @@
 #include "Conversions.h"
 
 VulkanSwapchain::VulkanSwapchain(vk::Device device, const VulkanSwapchainDesc& desc)
-    : m_Device(device),m_PresentationQueue(desc.presentationQueue),m_CurrentIndex(-1)
+    : m_Device(device),m_PresentationQueue(desc.presentationQueue),m_CurrentIndex(-1),m_Desc(desc)
 {
     ASSERT(desc.surfaceDetails.avlFormats.size(), "No Format is Suported");
     ASSERT(desc.surfaceDetails.avlPresentModes.size(), "No present mode is Suported");
 
-    vk::Format format;
-    vk::ColorSpaceKHR colorSpace;
     {
         bool found = false;
         for (auto& surfaceFormat : desc.surfaceDetails.avlFormats)
         {
             if (surfaceFormat.format == vk::Format::eR8G8B8A8Srgb && surfaceFormat.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear)
             {
-                format = surfaceFormat.format;
-                colorSpace = surfaceFormat.colorSpace;
+                m_Format = surfaceFormat.format;
+                m_ColorSpace = surfaceFormat.colorSpace;
                 found = true;
                 break;
             }
         }
         if (!found)
         {
-            format = desc.surfaceDetails.avlFormats[0].format;
-            colorSpace = desc.surfaceDetails.avlFormats[0].colorSpace;
+            m_Format = desc.surfaceDetails.avlFormats[0].format;
+            m_ColorSpace = desc.surfaceDetails.avlFormats[0].colorSpace;
         }
     }
 
-    vk::PresentModeKHR presentMode;
     {
 
         uint32_t i = 0;
         if (desc.presentMode == PresentMode::VSync)
         {
-            presentMode = vk::PresentModeKHR::eFifo;
+            m_PresentMode = vk::PresentModeKHR::eFifo;
         }
         else
         {
@@ -64,87 +61,12 @@ VulkanSwapchain::VulkanSwapchain(vk::Device device, const VulkanSwapchainDesc& d
             }
 
             ASSERT(bestScore > 0, "No present Mode is support");
-            presentMode = desc.surfaceDetails.avlPresentModes[bestIdx];
+            m_PresentMode = desc.surfaceDetails.avlPresentModes[bestIdx];
         }
 
     }
 
-    uint32_t minImageCount;
-    {
-        minImageCount = desc.surfaceDetails.capabilities.minImageCount + 1;
-        if (desc.surfaceDetails.capabilities.maxImageCount != 0)
-            minImageCount = std::min(minImageCount, desc.surfaceDetails.capabilities.maxImageCount);
-    }
-
-    vk::Extent2D extend;
-    {
-        auto& [w, h] = desc.imagesDimensions;
-
-        ASSERT((desc.surfaceDetails.capabilities.currentExtent.width  == UINT32_MAX) || (w >= desc.surfaceDetails.capabilities.minImageExtent.width && w <= desc.surfaceDetails.capabilities.maxImageExtent.width),"Incompatible Swapchain Image size");
-        ASSERT((desc.surfaceDetails.capabilities.currentExtent.height == UINT32_MAX) || (h >= desc.surfaceDetails.capabilities.minImageExtent.height && h <= desc.surfaceDetails.capabilities.maxImageExtent.height), "Incompatible Swapchain Image size");
-
-        extend = { w,h };
-    }
-
-    vk::SharingMode sharingMode;
-    std::vector<uint32_t> queues(desc.queueFamilies.begin(), desc.queueFamilies.end());
-    {
-        sharingMode = queues.size() == 1 ? vk::SharingMode::eExclusive : vk::SharingMode::eConcurrent;
-    }
-
-    vk::SwapchainCreateInfoKHR swapcahainInfo = { {},
-        desc.surfaceDetails.surface,
-        minImageCount,
-        format,colorSpace,
-        extend,
-        1,
-        vk::ImageUsageFlagBits::eColorAttachment,
-        sharingMode,(uint32_t)queues.size(),queues.data(),
-        vk::SurfaceTransformFlagBitsKHR::eIdentity,
-        vk::CompositeAlphaFlagBitsKHR::eOpaque,
-        presentMode,
-        true
-    };
-
-    m_Swapchain = device.createSwapchainKHR(swapcahainInfo);
-
-    m_ImagesDesc.format = GetFormat(format);
-    m_ImagesDesc.dimensions = { extend.width,extend.height,1 };
-    m_ImagesDesc.type = ImageType::e2D;
-    m_ImagesDesc.layers = 1;
-
-    auto images = device.getSwapchainImagesKHR(m_Swapchain);
-    m_Images.resize(images.size());
-    m_Views.resize(images.size());
-
-    VulkanImageDesc imageDesc;
-    {
-        imageDesc.dimensions = { desc.imagesDimensions.width,desc.imagesDimensions.height,1 };
-        imageDesc.format = GetFormat(format);
-        imageDesc.layers = 1;
-        imageDesc.owning = false;
-        imageDesc.queueFamilies = desc.queueFamilies;
-        imageDesc.type = ImageType::e2D;
-    }
-    for (uint32_t i = 0; i < m_Images.size(); i++)
-    {
-        imageDesc.preMadeHandle = images[i];
-        m_Images[i] = new VulkanImage(device, imageDesc);
-    }
-
-    VulkanImageViewDesc viewDesc;
-    {
-        viewDesc.baseLayer = 0;
-        viewDesc.layers = 1;
-        viewDesc.dimensions = m_ImagesDesc.dimensions;
-        viewDesc.type = ImageViewType::e2D;
-        viewDesc.aspect = ImageViewAspect::Color;
-    }
-    for (uint32_t i = 0; i < m_Views.size(); i++)
-    {
-        viewDesc.image = m_Images[i];
-        m_Views[i] = new VulkanImageView(device, viewDesc);
-    }
+    create(desc.imagesDimensions, desc.surfaceDetails.capabilities, nullptr);
 
     m_Fence = device.createFence({});
 }
@@ -271,16 +193,40 @@ VulkanSwapchain::VulkanSwapchain(vk::Device device, const VulkanSwapchainDesc& d
 */
 VulkanSwapchain::~VulkanSwapchain()
 {
-    for (auto& view : m_Views) delete view;
-    m_Device.destroySwapchainKHR(m_Swapchain);
+    for (auto& retired : m_Retired)
+        destroy(retired);
+    destroy({ m_Swapchain, std::move(m_Images), std::move(m_Views), 0 });
     m_Device.destroyFence(m_Fence);
 }
 
-SwapchainImage VulkanSwapchain::GetNextImage()
+SwapchainImage VulkanSwapchain::GetNextImage(Receipe* receipe)
 {
-    m_Device.resetFences(m_Fence);
-    m_CurrentIndex = m_Device.acquireNextImageKHR(m_Swapchain, UINT32_MAX, nullptr, m_Fence).value;
-    m_Device.waitForFences(m_Fence, true, UINT32_MAX);
+    collectRetired();
+
+    vk::Result result;
+    if (receipe)
+    {
+        vk::Semaphore signal = static_cast<VulkanReceipe*>(receipe)->getVkSemaphore();
+        result = m_Device.acquireNextImageKHR(m_Swapchain, UINT64_MAX, signal, nullptr, &m_CurrentIndex);
+    }
+    else
+    {
+        m_Device.resetFences(m_Fence);
+        result = m_Device.acquireNextImageKHR(m_Swapchain, UINT64_MAX, nullptr, m_Fence, &m_CurrentIndex);
+        if (result == vk::Result::eSuccess || result == vk::Result::eSuboptimalKHR)
+            m_Device.waitForFences(m_Fence, true, UINT64_MAX);
+    }
+
+    // A suboptimal image can still be rendered to, the swapchain is recreated at the next ReSize
+    if (result == vk::Result::eErrorOutOfDateKHR)
+    {
+        m_OutOfDate = true;
+        return { nullptr, UINT32_MAX };
+    }
+    ASSERT(result == vk::Result::eSuccess || result == vk::Result::eSuboptimalKHR, "Failed to acquire a swapchain image (%s)", vk::to_string(result).c_str());
+
+    m_OutOfDate |= (result == vk::Result::eSuboptimalKHR);
+    m_AcquireCount++;
 
     return {m_Views[m_CurrentIndex],m_CurrentIndex };
 }
@@ -298,7 +244,135 @@ void VulkanSwapchain::Present(ArrayProxy<Receipe*> receipes)
         .setWaitSemaphoreCount(semaphores.size()).setPWaitSemaphores(semaphores.data())
         .setPImageIndices(&m_CurrentIndex);
     
-    m_PresentationQueue.presentKHR(presentInfo);
+    vk::Result result = m_PresentationQueue.presentKHR(&presentInfo);
+
+    if (result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR)
+        m_OutOfDate = true;
+    else
+        ASSERT(result == vk::Result::eSuccess, "Failed to present (%s)", vk::to_string(result).c_str());
+}
+
+void VulkanSwapchain::ReSize(Dimensions2Du dimensions)
+{
+    vk::SurfaceCapabilitiesKHR capabilities = m_Desc.physicalDevice.getSurfaceCapabilitiesKHR(m_Desc.surfaceDetails.surface);
+
+    // A minimized window has a zero sized surface, nothing can be created until it comes back
+    if (capabilities.currentExtent.width == 0 || capabilities.currentExtent.height == 0 || dimensions.width == 0 || dimensions.height == 0)
+    {
+        m_OutOfDate = true;
+        return;
+    }
+
+    // The old swapchain is handed to the driver so it can reuse its images, it is only destroyed
+    // once enough images were acquired from the new one for the frames that used it to be done
+    uint64_t retireDelay = std::max<uint64_t>(m_Desc.framesInFlight, m_Images.size());
+    m_Retired.push_back({ m_Swapchain, std::move(m_Images), std::move(m_Views), m_AcquireCount + retireDelay });
+
+    create(dimensions, capabilities, m_Retired.back().swapchain);
+
+    m_OutOfDate = false;
+    m_Generation++;
 }
 
+inline void VulkanSwapchain::create(Dimensions2Du dimensions, const vk::SurfaceCapabilitiesKHR& capabilities, vk::SwapchainKHR oldSwapchain)
+{
+    uint32_t minImageCount;
+    {
+        minImageCount = capabilities.minImageCount + 1;
+        if (capabilities.maxImageCount != 0)
+            minImageCount = std::min(minImageCount, capabilities.maxImageCount);
+    }
+
+    vk::Extent2D extend;
+    {
+        if (capabilities.currentExtent.width == UINT32_MAX)
+        {
+            extend.width = std::clamp(dimensions.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+            extend.height = std::clamp(dimensions.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+        }
+        else
+        {
+            extend = capabilities.currentExtent;
+        }
+    }
+
+    vk::SharingMode sharingMode;
+    std::vector<uint32_t> queues(m_Desc.queueFamilies.begin(), m_Desc.queueFamilies.end());
+    {
+        sharingMode = queues.size() == 1 ? vk::SharingMode::eExclusive : vk::SharingMode::eConcurrent;
+    }
+
+    vk::SwapchainCreateInfoKHR swapcahainInfo = { {},
+        m_Desc.surfaceDetails.surface,
+        minImageCount,
+        m_Format,m_ColorSpace,
+        extend,
+        1,
+        vk::ImageUsageFlagBits::eColorAttachment,
+        sharingMode,(uint32_t)queues.size(),queues.data(),
+        vk::SurfaceTransformFlagBitsKHR::eIdentity,
+        vk::CompositeAlphaFlagBitsKHR::eOpaque,
+        m_PresentMode,
+        true,
+        oldSwapchain
+    };
+
+    m_Swapchain = m_Device.createSwapchainKHR(swapcahainInfo);
 
+    m_ImagesDesc.format = GetFormat(m_Format);
+    m_ImagesDesc.dimensions = { extend.width,extend.height,1 };
+    m_ImagesDesc.type = ImageType::e2D;
+    m_ImagesDesc.layers = 1;
+
+    auto images = m_Device.getSwapchainImagesKHR(m_Swapchain);
+    m_Images.resize(images.size());
+    m_Views.resize(images.size());
+
+    VulkanImageDesc imageDesc;
+    {
+        imageDesc.dimensions = m_ImagesDesc.dimensions;
+        imageDesc.format = m_ImagesDesc.format;
+        imageDesc.layers = 1;
+        imageDesc.owning = false;
+        imageDesc.queueFamilies = m_Desc.queueFamilies;
+        imageDesc.type = ImageType::e2D;
+    }
+    for (uint32_t i = 0; i < m_Images.size(); i++)
+    {
+        imageDesc.preMadeHandle = images[i];
+        m_Images[i] = new VulkanImage(m_Device, imageDesc);
+    }
+
+    VulkanImageViewDesc viewDesc;
+    {
+        viewDesc.baseLayer = 0;
+        viewDesc.layers = 1;
+        viewDesc.dimensions = m_ImagesDesc.dimensions;
+        viewDesc.type = ImageViewType::e2D;
+        viewDesc.aspect = ImageViewAspect::Color;
+    }
+    for (uint32_t i = 0; i < m_Views.size(); i++)
+    {
+        viewDesc.image = m_Images[i];
+        m_Views[i] = new VulkanImageView(m_Device, viewDesc);
+    }
+}
+
+inline void VulkanSwapchain::collectRetired()
+{
+    auto it = std::remove_if(m_Retired.begin(), m_Retired.end(), [&](Retired& retired)
+        {
+            if (retired.destroyAt > m_AcquireCount)
+                return false;
+            destroy(retired);
+            return true;
+        });
+    m_Retired.erase(it, m_Retired.end());
+}
+
+inline void VulkanSwapchain::destroy(const Retired& retired)
+{
+    for (auto& view : retired.views) delete view;
+    for (auto& image : retired.images) delete image;
+    m_Device.destroySwapchainKHR(retired.swapchain);
+}
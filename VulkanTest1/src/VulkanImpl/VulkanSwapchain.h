@@ -13,6 +13,8 @@ struct VulkanSwapchainDesc : public SwapchainDesc
 	VulkanSurfaceDetails surfaceDetails;
 	std::set<uint32_t> queueFamilies;
 	vk::Queue presentationQueue;
+	vk::PhysicalDevice physicalDevice;
+	uint32_t framesInFlight = 2;
 };
 
 class VulkanSwapchain : public Swapchain
@@ -21,14 +23,29 @@ public:
 	VulkanSwapchain(vk::Device device, const VulkanSwapchainDesc& desc);
 	~VulkanSwapchain();
 
-	virtual SwapchainImage GetNextImage() override;
+	virtual SwapchainImage GetNextImage(Receipe* receipe = nullptr) override;
 	virtual void Present(ArrayProxy<Receipe*> receipes) override;
-	virtual void ReSize(Dimensions2Du dimensions) { ASSERT(false, "not implemented yet"); }
+	virtual void ReSize(Dimensions2Du dimensions) override;
+
+	inline virtual bool IsOutOfDate() const override { return m_OutOfDate; }
+	inline virtual uint32_t GetGeneration() const override { return m_Generation; }
 
 	inline virtual const ImageDesc& GetImagesDesc() const override { return m_ImagesDesc; };
 	inline virtual uint32_t GetImageCount() const override { return m_Images.size(); }
 	inline virtual ImageView* GetImageView(uint32_t i) override { return m_Views[i]; }
 
+private:
+	struct Retired
+	{
+		vk::SwapchainKHR swapchain;
+		std::vector<Image*> images;
+		std::vector<ImageView*> views;
+		uint64_t destroyAt;
+	};
+
+	inline void create(Dimensions2Du dimensions, const vk::SurfaceCapabilitiesKHR& capabilities, vk::SwapchainKHR oldSwapchain);
+	inline void collectRetired();
+	inline void destroy(const Retired& retired);
 private:
 	vk::Device m_Device;
 	vk::SwapchainKHR m_Swapchain;
@@ -40,4 +57,14 @@ private:
 	ImageDesc m_ImagesDesc;
 
 	uint32_t m_CurrentIndex;
+
+	VulkanSwapchainDesc m_Desc;
+	vk::Format m_Format;
+	vk::ColorSpaceKHR m_ColorSpace;
+	vk::PresentModeKHR m_PresentMode;
+
+	std::vector<Retired> m_Retired;
+	uint64_t m_AcquireCount = 0;
+	uint32_t m_Generation = 0;
+	bool m_OutOfDate = false;
 };
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "pch.h"
+#include "VulkanUniformRing.h"
+
+inline static vk::DeviceSize AlignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+vk::DeviceSize VulkanUniformRing::GetAlignment(VulkanRenderDevice* device)
+{
+	// Regions can also be read as storage buffers, both alignments are powers of two
+	return std::max<vk::DeviceSize>({ device->getLimits().minUniformBufferOffsetAlignment, device->getLimits().minStorageBufferOffsetAlignment, 1 });
+}
+
+VulkanUniformRing::VulkanUniformRing(VulkanRenderDevice* device, vk::DeviceSize frameSize, uint32_t frameCount)
+{
+	ASSERT(frameCount, "A uniform ring needs at least one frame");
+
+	m_Alignment = GetAlignment(device);
+	m_FrameSize = AlignUp(frameSize, m_Alignment);
+	m_FrameCount = frameCount;
+
+	BufferDesc desc; {
+		desc.usage = BufferUsageBits::UniformBuffer | BufferUsageBits::StorageBuffer | BufferUsageBits::VertexBuffer;
+		desc.size = m_FrameSize * m_FrameCount;
+		desc.gpuAccessRate = ResourceAccessRate::Frequent;
+		desc.cpuAccessibility = ResourceAccessibilityBits::Write;
+		desc.persistentlyMapped = true;
+	}
+	m_Buffer = static_cast<VulkanBuffer*>(device->CreateBuffer(desc));
+	m_Mapped = (char*)m_Buffer->GetMappedData();
+}
+
+VulkanUniformRing::~VulkanUniformRing()
+{
+	delete m_Buffer;
+}
+
+void VulkanUniformRing::BeginFrame(uint32_t frameIndex)
+{
+	ASSERT(frameIndex < m_FrameCount, "Frame index %u is out of the ring (%u frames)", frameIndex, m_FrameCount);
+
+	m_FrameBegin = m_FrameSize * frameIndex;
+	m_Head = m_FrameBegin;
+}
+
+UniformSlice VulkanUniformRing::Allocate(vk::DeviceSize size)
+{
+	vk::DeviceSize offset = m_Head;
+	ASSERT(offset + size <= m_FrameBegin + m_FrameSize, "Uniform ring is full (%llu bytes per frame)", (unsigned long long)m_FrameSize);
+
+	m_Head = AlignUp(offset + size, m_Alignment);
+	return { m_Mapped + offset, (uint32_t)offset };
+}
+
+void VulkanUniformRing::EndFrame()
+{
+	if (m_Head > m_FrameBegin)
+		m_Buffer->Flush(m_FrameBegin, m_Head - m_FrameBegin);
+}
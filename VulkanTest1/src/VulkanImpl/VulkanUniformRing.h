@@ -0,0 +1,58 @@
+#pragma once
+
+#include "VulkanImpl/VulkanRenderDevice.h"
+#include "VulkanImpl/VulkanBuffer.h"
+#include <vulkan/vulkan.hpp>
+
+struct UniformSlice
+{
+	void* data = nullptr;
+	uint32_t offset = 0;
+};
+
+/*
+	One persistently mapped uniform buffer split in one region per frame in flight.
+	Each frame linearly allocates slices (aligned to GetAlignment()) from its own region,
+	the slices are bound through an eUniformBufferDynamic descriptor with their offset as the dynamic offset.
+	A region is only rewritten once the frame that used it is done, the caller is responsible for waiting on it.
+	The buffer is also a storage buffer, a region can be bound as a whole and indexed from the shaders,
+	and a vertex buffer for per instance streams.
+*/
+class VulkanUniformRing
+{
+public:
+	VulkanUniformRing(VulkanRenderDevice* device, vk::DeviceSize frameSize, uint32_t frameCount);
+	~VulkanUniformRing();
+
+	// What every slice is aligned to, frame sizes have to account for it
+	static vk::DeviceSize GetAlignment(VulkanRenderDevice* device);
+
+	void BeginFrame(uint32_t frameIndex);
+	UniformSlice Allocate(vk::DeviceSize size);
+	// Flushes what was written since BeginFrame
+	void EndFrame();
+
+	template<typename T>
+	inline uint32_t Push(const T& data)
+	{
+		UniformSlice slice = Allocate(sizeof(T));
+		memcpy(slice.data, &data, sizeof(T));
+		return slice.offset;
+	}
+public:
+	inline vk::Buffer getVkBuffer() { return m_Buffer->getVkBuffer(); }
+	inline vk::DeviceSize getFrameSize() const { return m_FrameSize; }
+	inline vk::DeviceSize getAlignment() const { return m_Alignment; }
+	inline vk::DeviceSize getFrameOffset(uint32_t frameIndex) const { return m_FrameSize * frameIndex; }
+
+private:
+	VulkanBuffer* m_Buffer;
+	char* m_Mapped;
+
+	vk::DeviceSize m_Alignment;
+	vk::DeviceSize m_FrameSize;
+	uint32_t m_FrameCount;
+
+	vk::DeviceSize m_FrameBegin = 0;
+	vk::DeviceSize m_Head = 0;
+};
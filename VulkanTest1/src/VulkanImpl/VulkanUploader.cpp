@@ -0,0 +1,417 @@
+#include "pch.h"
+#include "VulkanUploader.h"
+
+inline static vk::DeviceSize AlignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+struct UploadBatch
+{
+	uint64_t id = 0;
+
+	vk::CommandBuffer transferCmd, acquireCmd;
+	vk::Fence fence;
+	vk::Semaphore semaphore;
+
+	// Part of the ring written by the batch, wraps when the end is before the begin
+	bool usesRing = false;
+	vk::DeviceSize stagingBegin = 0, stagingEnd = 0;
+	std::vector<VulkanBuffer*> temporaries;
+
+	// Recorded after the copies, they either finish the upload (same family) or release the resources to the graphics family
+	std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+	std::vector<vk::ImageMemoryBarrier> imageBarriers;
+	vk::PipelineStageFlags dstStages = {};
+
+	// Graphics side of the ownership transfers
+	std::vector<vk::BufferMemoryBarrier> bufferAcquires;
+	std::vector<vk::ImageMemoryBarrier> imageAcquires;
+
+	std::vector<VulkanImageUpload> mipJobs;
+	std::vector<MipChainResources> mipResources;
+};
+
+VulkanUploader::VulkanUploader(VulkanRenderDevice* device, vk::DeviceSize stagingSize)
+	:m_Device(device), m_VkDevice(device->getDevice()), m_StagingSize(stagingSize)
+{
+	m_TransferQueue = device->getTransferQueue();
+	m_TransferFamily = device->getTransferFamily();
+	m_GraphicsQueue = device->getGraphicsQueue() ? device->getGraphicsQueue() : device->getComputeQueue();
+	m_GraphicsFamily = device->getGraphicsQueue() ? device->getGraphicsFamily() : device->getComputeFamily();
+
+	m_TransferPool = m_VkDevice.createCommandPool({ vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient, m_TransferFamily });
+	if (needsOwnershipTransfer())
+		m_GraphicsPool = m_VkDevice.createCommandPool({ vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient, m_GraphicsFamily });
+
+	BufferDesc desc; {
+		desc.usage = BufferUsageBits::TransferSrc;
+		desc.size = stagingSize;
+		desc.gpuAccessRate = ResourceAccessRate::Rare;
+		desc.cpuAccessibility = ResourceAccessibilityBits::Write;
+		desc.persistentlyMapped = true;
+	}
+	m_Staging = static_cast<VulkanBuffer*>(device->CreateBuffer(desc));
+	m_StagingData = (char*)m_Staging->GetMappedData();
+
+	// Blits need a graphics queue, a compute only device always goes through the compute path
+	m_MipGenerator = new VulkanMipGenerator(device, (bool)device->getGraphicsQueue());
+
+	LOG_INFO("Uploads go through queue family %u%s", m_TransferFamily, needsOwnershipTransfer() ? " (dedicated)" : "");
+}
+
+VulkanUploader::~VulkanUploader()
+{
+	WaitIdle();
+
+	for (auto batch : m_FreeBatches)
+	{
+		m_VkDevice.destroyFence(batch->fence);
+		m_VkDevice.destroySemaphore(batch->semaphore);
+		delete batch;
+	}
+
+	m_VkDevice.destroyCommandPool(m_TransferPool);
+	if (m_GraphicsPool)
+		m_VkDevice.destroyCommandPool(m_GraphicsPool);
+
+	delete m_MipGenerator;
+	delete m_Staging;
+}
+
+UploadToken VulkanUploader::UploadBuffer(VulkanBuffer* dst, const void* data, vk::DeviceSize size, vk::DeviceSize dstOffset,
+	vk::PipelineStageFlags dstStages, vk::AccessFlags dstAccess)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+	vk::Buffer staging;
+	vk::DeviceSize stagingOffset;
+	void* ptr = allocateStaging(size, 16, staging, stagingOffset);
+	memcpy(ptr, data, size);
+
+	UploadBatch* batch = getBatch();
+	batch->transferCmd.copyBuffer(staging, dst->getVkBuffer(), vk::BufferCopy(stagingOffset, dstOffset, size));
+
+	auto barrier = vk::BufferMemoryBarrier()
+		.setBuffer(dst->getVkBuffer())
+		.setOffset(dstOffset).setSize(size)
+		.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+		.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED).setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+
+	// Concurrent buffers are usable by every listed family, no ownership to hand over
+	if (needsOwnershipTransfer() && dst->getVkSharingMode() == vk::SharingMode::eExclusive)
+	{
+		barrier.setSrcQueueFamilyIndex(m_TransferFamily).setDstQueueFamilyIndex(m_GraphicsFamily);
+		batch->bufferBarriers.push_back(vk::BufferMemoryBarrier(barrier).setDstAccessMask({}));
+		batch->bufferAcquires.push_back(vk::BufferMemoryBarrier(barrier).setSrcAccessMask({}).setDstAccessMask(dstAccess));
+	}
+	else if (needsOwnershipTransfer())
+	{
+		batch->bufferAcquires.push_back(vk::BufferMemoryBarrier(barrier).setSrcAccessMask({}).setDstAccessMask(dstAccess));
+	}
+	else
+	{
+		batch->bufferBarriers.push_back(barrier.setDstAccessMask(dstAccess));
+	}
+	batch->dstStages |= dstStages;
+
+	return { batch->id };
+}
+
+UploadToken VulkanUploader::UploadImage(const VulkanImageUpload& dst, const void* data, vk::DeviceSize size)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+	const vk::DeviceSize alignment = std::max<vk::DeviceSize>(m_Device->getLimits().optimalBufferCopyOffsetAlignment, 16);
+	const bool generateMips = dst.mipLevels > 1;
+
+	vk::Buffer staging;
+	vk::DeviceSize stagingOffset;
+	void* ptr = allocateStaging(size, alignment, staging, stagingOffset);
+	memcpy(ptr, data, size);
+
+	UploadBatch* batch = getBatch();
+
+	auto barrier = vk::ImageMemoryBarrier()
+		.setImage(dst.image)
+		.setOldLayout(vk::ImageLayout::eUndefined)
+		.setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+		.setSubresourceRange({ vk::ImageAspectFlagBits::eColor,0,dst.mipLevels,0,1 })
+		.setSrcAccessMask({})
+		.setDstAccessMask(vk::AccessFlagBits::eTransferWrite)
+		.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+		.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+
+	auto region = vk::BufferImageCopy()
+		.setBufferOffset(stagingOffset)
+		.setBufferImageHeight(0)
+		.setBufferRowLength(0)
+		.setImageExtent(dst.extent)
+		.setImageOffset(0)
+		.setImageSubresource({ vk::ImageAspectFlagBits::eColor,0,0,1 });
+
+	batch->transferCmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, barrier);
+	batch->transferCmd.copyBufferToImage(staging, dst.image, vk::ImageLayout::eTransferDstOptimal, region);
+
+	barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite).setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+
+	// The mip chain is generated where the image ends up (the graphics side), the generator does the final transition.
+	// Otherwise the image goes straight to its final layout, the transition has to be identical in the release and the acquire barriers
+	vk::AccessFlags acquireAccess = dst.dstAccess;
+	if (generateMips)
+	{
+		barrier.setNewLayout(vk::ImageLayout::eTransferDstOptimal);
+		acquireAccess = vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+		batch->mipJobs.push_back(dst);
+	}
+	else
+	{
+		barrier.setNewLayout(dst.finalLayout);
+	}
+
+	if (needsOwnershipTransfer())
+	{
+		barrier.setSrcQueueFamilyIndex(m_TransferFamily).setDstQueueFamilyIndex(m_GraphicsFamily);
+		batch->imageBarriers.push_back(vk::ImageMemoryBarrier(barrier).setDstAccessMask({}));
+		batch->imageAcquires.push_back(vk::ImageMemoryBarrier(barrier).setSrcAccessMask({}).setDstAccessMask(acquireAccess));
+		batch->dstStages |= generateMips ? vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader : dst.dstStages;
+	}
+	else if (!generateMips)
+	{
+		batch->imageBarriers.push_back(barrier.setDstAccessMask(dst.dstAccess));
+		batch->dstStages |= dst.dstStages;
+	}
+
+	return { batch->id };
+}
+
+UploadToken VulkanUploader::Submit()
+{
+	std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+	submitBatch();
+	collect(false);
+
+	return { m_NextBatch - 1 };
+}
+
+bool VulkanUploader::IsComplete(UploadToken token)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+	collect(false);
+	return m_CompletedBatch >= token.value;
+}
+
+void VulkanUploader::Wait(UploadToken token)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+	if (m_Current && token.value >= m_Current->id)
+		submitBatch();
+
+	while (m_CompletedBatch < token.value && !m_InFlight.empty())
+		collect(true);
+}
+
+void VulkanUploader::WaitIdle()
+{
+	std::lock_guard<std::recursive_mutex> lock(m_Mutex);
+
+	submitBatch();
+	while (!m_InFlight.empty())
+		collect(true);
+}
+
+UploadBatch* VulkanUploader::getBatch()
+{
+	if (m_Current)
+		return m_Current;
+
+	UploadBatch* batch;
+	if (m_FreeBatches.size())
+	{
+		batch = m_FreeBatches.back();
+		m_FreeBatches.pop_back();
+		m_VkDevice.resetFences(batch->fence);
+	}
+	else
+	{
+		batch = new UploadBatch();
+		batch->fence = m_VkDevice.createFence({});
+		batch->semaphore = m_VkDevice.createSemaphore({});
+		batch->transferCmd = m_VkDevice.allocateCommandBuffers({ m_TransferPool, vk::CommandBufferLevel::ePrimary, 1 })[0];
+		if (needsOwnershipTransfer())
+			batch->acquireCmd = m_VkDevice.allocateCommandBuffers({ m_GraphicsPool, vk::CommandBufferLevel::ePrimary, 1 })[0];
+	}
+
+	batch->id = m_NextBatch++;
+	batch->transferCmd.begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+
+	m_Current = batch;
+	return batch;
+}
+
+void* VulkanUploader::allocateStaging(vk::DeviceSize size, vk::DeviceSize alignment, vk::Buffer& outBuffer, vk::DeviceSize& outOffset)
+{
+	// Bigger than the whole ring : a staging buffer of its own that lives as long as the batch
+	if (size > m_StagingSize)
+	{
+		BufferDesc desc = m_Staging->GetDesc();
+		desc.size = size;
+
+		VulkanBuffer* temporary = static_cast<VulkanBuffer*>(m_Device->CreateBuffer(desc));
+		getBatch()->temporaries.push_back(temporary);
+
+		outBuffer = temporary->getVkBuffer();
+		outOffset = 0;
+		return temporary->GetMappedData();
+	}
+
+	// Ring is full : push what is pending and recycle the oldest batches until there is room
+	while (!tryAllocateRing(size, alignment, outOffset))
+	{
+		submitBatch();
+		ASSERT(!m_InFlight.empty(), "Staging ring (%llu bytes) cannot fit %llu bytes", (unsigned long long)m_StagingSize, (unsigned long long)size);
+		collect(true);
+	}
+
+	UploadBatch* batch = getBatch();
+	if (!batch->usesRing)
+		batch->stagingBegin = outOffset;
+	batch->usesRing = true;
+	batch->stagingEnd = m_Head;
+
+	outBuffer = m_Staging->getVkBuffer();
+	return m_StagingData + outOffset;
+}
+
+bool VulkanUploader::tryAllocateRing(vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& outOffset)
+{
+	// Used bytes are [tail, head) wrapping at the end of the ring, head never catches up with tail unless the ring is empty
+	vk::DeviceSize offset = AlignUp(m_Head, alignment);
+
+	if (m_Head >= m_Tail)
+	{
+		if (offset + size > m_StagingSize)
+		{
+			if (size >= m_Tail)
+				return false;
+			offset = 0;
+		}
+	}
+	else if (offset + size >= m_Tail)
+	{
+		return false;
+	}
+
+	m_Head = offset + size;
+	outOffset = offset;
+	return true;
+}
+
+void VulkanUploader::submitBatch()
+{
+	UploadBatch* batch = m_Current;
+	if (!batch)
+		return;
+	m_Current = nullptr;
+
+	if (batch->usesRing)
+	{
+		if (batch->stagingBegin < batch->stagingEnd)
+		{
+			m_Staging->Flush(batch->stagingBegin, batch->stagingEnd - batch->stagingBegin);
+		}
+		else
+		{
+			m_Staging->Flush(batch->stagingBegin, m_StagingSize - batch->stagingBegin);
+			m_Staging->Flush(0, batch->stagingEnd);
+		}
+	}
+	for (auto temporary : batch->temporaries)
+		temporary->Flush(0, temporary->GetDesc().size);
+
+	const vk::PipelineStageFlags afterCopy = needsOwnershipTransfer() ? vk::PipelineStageFlagBits::eBottomOfPipe : batch->dstStages;
+	if (batch->bufferBarriers.size() || batch->imageBarriers.size())
+		batch->transferCmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, afterCopy, {}, nullptr, batch->bufferBarriers, batch->imageBarriers);
+
+	if (needsOwnershipTransfer())
+	{
+		batch->transferCmd.end();
+
+		vk::PipelineStageFlags waitStages = batch->dstStages ? batch->dstStages : vk::PipelineStageFlagBits::eTopOfPipe;
+
+		batch->acquireCmd.begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+		// Starts at the stages the semaphore waits at, otherwise the acquire isn't chained to the release
+		if (batch->bufferAcquires.size() || batch->imageAcquires.size())
+			batch->acquireCmd.pipelineBarrier(waitStages, batch->dstStages, {}, nullptr, batch->bufferAcquires, batch->imageAcquires);
+		for (const auto& job : batch->mipJobs)
+			batch->mipResources.push_back(m_MipGenerator->Record(batch->acquireCmd, job));
+		batch->acquireCmd.end();
+
+		auto transferSubmit = vk::SubmitInfo()
+			.setCommandBufferCount(1).setPCommandBuffers(&batch->transferCmd)
+			.setSignalSemaphoreCount(1).setPSignalSemaphores(&batch->semaphore);
+		auto acquireSubmit = vk::SubmitInfo()
+			.setCommandBufferCount(1).setPCommandBuffers(&batch->acquireCmd)
+			.setWaitSemaphoreCount(1).setPWaitSemaphores(&batch->semaphore)
+			.setPWaitDstStageMask(&waitStages);
+
+		m_TransferQueue.submit(transferSubmit, nullptr);
+		m_GraphicsQueue.submit(acquireSubmit, batch->fence);
+	}
+	else
+	{
+		for (const auto& job : batch->mipJobs)
+			batch->mipResources.push_back(m_MipGenerator->Record(batch->transferCmd, job));
+		batch->transferCmd.end();
+
+		auto submitInfo = vk::SubmitInfo().setCommandBufferCount(1).setPCommandBuffers(&batch->transferCmd);
+		m_TransferQueue.submit(submitInfo, batch->fence);
+	}
+
+	batch->mipJobs.clear();
+	m_InFlight.push_back(batch);
+}
+
+void VulkanUploader::collect(bool wait)
+{
+	while (!m_InFlight.empty())
+	{
+		UploadBatch* batch = m_InFlight.front();
+
+		if (wait)
+		{
+			m_VkDevice.waitForFences(batch->fence, true, UINT64_MAX);
+			wait = false;
+		}
+		else if (m_VkDevice.getFenceStatus(batch->fence) != vk::Result::eSuccess)
+		{
+			break;
+		}
+
+		if (batch->usesRing)
+			m_Tail = batch->stagingEnd;
+		for (auto temporary : batch->temporaries)
+			delete temporary;
+		for (auto& resources : batch->mipResources)
+			m_MipGenerator->Destroy(resources);
+
+		batch->temporaries.clear();
+		batch->mipResources.clear();
+		batch->bufferBarriers.clear();
+		batch->imageBarriers.clear();
+		batch->bufferAcquires.clear();
+		batch->imageAcquires.clear();
+		batch->dstStages = {};
+		batch->usesRing = false;
+
+		m_CompletedBatch = batch->id;
+		m_InFlight.pop_front();
+		m_FreeBatches.push_back(batch);
+	}
+
+	if (m_InFlight.empty() && !(m_Current && m_Current->usesRing))
+		m_Head = m_Tail = 0;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "VulkanImpl/VulkanRenderDevice.h"
+#include "VulkanImpl/VulkanBuffer.h"
+#include "VulkanImpl/VulkanMipGenerator.h"
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+// Identifies the batch an upload went into, batches complete in submission order
+struct UploadToken
+{
+	uint64_t value = 0;
+};
+
+// Destination of an image upload : a color image created with eExclusive sharing, whose first layer gets filled
+struct VulkanImageUpload
+{
+	vk::Image image;
+	vk::Format format;
+	vk::Extent3D extent;
+	// Levels past the first one are generated from it on the gpu
+	uint32_t mipLevels = 1;
+
+	vk::ImageLayout finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+	vk::PipelineStageFlags dstStages = vk::PipelineStageFlagBits::eFragmentShader;
+	vk::AccessFlags dstAccess = vk::AccessFlagBits::eShaderRead;
+};
+
+struct UploadBatch;
+
+/*
+	Copies data to device local resources through a persistently mapped staging ring.
+	Uploads are recorded into the current batch and go to the gpu in one submission on Submit()
+	(or when the ring is full). When the device has a dedicated transfer family the copies run
+	on its queue and the resources are handed over to the graphics family with queue family ownership
+	transfers, the acquire half is submitted on the graphics queue and waits on the copies with a semaphore.
+	The rendering does not need to wait for a token : commands submitted on the graphics queue after
+	Submit() are ordered after the acquire barriers. Tokens are there to know when the data
+	(and the staging memory) is no longer in use.
+
+	Submit() (and uploads that end up submitting a full batch) touch the graphics queue,
+	they must be called from the thread that submits the rendering.
+*/
+class VulkanUploader
+{
+public:
+	static constexpr vk::DeviceSize DefaultStagingSize = 32ull * 1024 * 1024;
+
+	VulkanUploader(VulkanRenderDevice* device, vk::DeviceSize stagingSize = DefaultStagingSize);
+	~VulkanUploader();
+
+	// dstStages/dstAccess describe the first use of the data on the graphics queue
+	UploadToken UploadBuffer(VulkanBuffer* dst, const void* data, vk::DeviceSize size, vk::DeviceSize dstOffset,
+		vk::PipelineStageFlags dstStages, vk::AccessFlags dstAccess);
+	// data holds the first mip level, the image content before the upload is discarded
+	UploadToken UploadImage(const VulkanImageUpload& dst, const void* data, vk::DeviceSize size);
+
+	UploadToken Submit();
+
+	bool IsComplete(UploadToken token);
+	void Wait(UploadToken token);
+	void WaitIdle();
+
+	inline const VulkanMipGenerator* GetMipGenerator() const { return m_MipGenerator; }
+private:
+	UploadBatch* getBatch();
+	void* allocateStaging(vk::DeviceSize size, vk::DeviceSize alignment, vk::Buffer& outBuffer, vk::DeviceSize& outOffset);
+	bool tryAllocateRing(vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& outOffset);
+	void submitBatch();
+	void collect(bool wait);
+
+	inline bool needsOwnershipTransfer() const { return m_TransferFamily != m_GraphicsFamily; }
+private:
+	VulkanRenderDevice* m_Device;
+	vk::Device m_VkDevice;
+
+	vk::Queue m_TransferQueue, m_GraphicsQueue;
+	uint32_t m_TransferFamily, m_GraphicsFamily;
+	vk::CommandPool m_TransferPool, m_GraphicsPool;
+
+	VulkanMipGenerator* m_MipGenerator;
+
+	VulkanBuffer* m_Staging;
+	char* m_StagingData;
+	vk::DeviceSize m_StagingSize;
+	vk::DeviceSize m_Head = 0, m_Tail = 0;
+
+	UploadBatch* m_Current = nullptr;
+	std::deque<UploadBatch*> m_InFlight;
+	std::vector<UploadBatch*> m_FreeBatches;
+
+	uint64_t m_NextBatch = 1;
+	uint64_t m_CompletedBatch = 0;
+
+	std::recursive_mutex m_Mutex;
+};
@@ -8,6 +8,7 @@ struct BufferDesc
 	size_t size = 0;
 	ResourceAccessRate gpuAccessRate = ResourceAccessRate::Frequent;
 	ResourceAccessibilityBits cpuAccessibility = ResourceAccessibilityBits::None;
+	bool persistentlyMapped = false;
 };
 
 class Buffer
@@ -17,5 +18,12 @@ public:
 
 	virtual void* Map() = 0;
 	virtual void UnMap() = 0;
+
+	// Persistently mapped buffers only : the pointer stays valid for the lifetime of the buffer,
+	// writes/reads are made visible by flushing/invalidating the touched range.
+	virtual void* GetMappedData() = 0;
+	virtual void Flush(size_t offset, size_t size) = 0;
+	virtual void Invalidate(size_t offset, size_t size) = 0;
+
 	virtual const BufferDesc& GetDesc() const = 0;
 };
\ No newline at end of file
@@ -58,6 +58,18 @@ enum class ImageType : uint8_t
 	e3D
 };
 
+enum class ImageTiling : uint8_t
+{
+	Optimal,
+	Linear
+};
+
+enum class ImageInitialLayout : uint8_t
+{
+	Undefined,
+	Preinitialized
+};
+
 enum class ImageViewType : uint8_t
 {
 	e1D, e2D, e3D,
@@ -95,10 +107,23 @@ enum class BufferUsageBits : uint32_t
 	VertexBuffer = Bit(2),
 	IndexBuffer = Bit(3),
 	UniformBuffer = Bit(4),
-	StorageBuffer = Bit(5)
+	StorageBuffer = Bit(5),
+	IndirectBuffer = Bit(6)
+};
+
+enum class ImageUsageBits : uint32_t
+{
+	NoUse = 0,
+	TransferSrc = Bit(0),
+	TransferDst = Bit(1),
+	Sampled = Bit(2),
+	Storage = Bit(3),
+	ColorAttachment = Bit(4),
+	DepthStencilAttachment = Bit(5)
 };
 
 typedef Flags<BufferUsageBits> BufferUsageFlags;
+typedef Flags<ImageUsageBits> ImageUsageFlags;
 typedef Flags<ResourceAccessibilityBits> ResourceAccessibilityFlags;
 
 inline static constexpr BufferUsageFlags operator&(const BufferUsageBits& a, const BufferUsageBits& b)
@@ -109,6 +134,14 @@ inline static constexpr BufferUsageFlags operator|(const BufferUsageBits& a, con
 {
 	return BufferUsageFlags(a) | b;
 }
+inline static constexpr ImageUsageFlags operator&(const ImageUsageBits& a, const ImageUsageBits& b)
+{
+	return ImageUsageFlags(a) & b;
+}
+inline static constexpr ImageUsageFlags operator|(const ImageUsageBits& a, const ImageUsageBits& b)
+{
+	return ImageUsageFlags(a) | b;
+}
 inline static constexpr ResourceAccessibilityFlags operator&(const ResourceAccessibilityBits& a, const ResourceAccessibilityBits& b)
 {
 	return ResourceAccessibilityFlags(a) & b;
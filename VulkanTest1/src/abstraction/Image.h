@@ -6,10 +6,16 @@
 struct ImageDesc
 {
 	Dimensions3Du dimensions;
-	uint32_t layers;
+	uint32_t layers = 1;
 	ImageFormat format;
 	ImageType type;
 
+	ImageUsageFlags usage = ImageUsageBits::NoUse;
+	uint32_t mipLevels = 1;
+	uint32_t samples = 1;
+	ImageTiling tiling = ImageTiling::Optimal;
+	ImageInitialLayout initialLayout = ImageInitialLayout::Undefined;
+
 	ResourceAccessRate gpuAccessRate = ResourceAccessRate::Frequent;
 	ResourceAccessibilityBits cpuAccessibility = ResourceAccessibilityBits::None;
 };
@@ -9,6 +9,8 @@ struct ImageViewDesc
 	Dimensions3Du dimensions;
 	uint32_t baseLayer = 0;
 	uint32_t layers;
+	uint32_t baseMipLevel = 0;
+	uint32_t mipLevels = 1;
 	ImageViewType type;
 	ImageViewAspect aspect;
 };
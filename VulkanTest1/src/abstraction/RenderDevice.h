@@ -3,14 +3,29 @@
 #include <string>
 #include "abstraction/Swapchain.h"
 #include "abstraction/Buffer.h"
+#include "abstraction/Image.h"
+#include "abstraction/ImageView.h"
 
 struct GLFWwindow;
 
 struct RenderDeviceDesc
 {
+	// Without a window the device is headless, the swapchain renders into offscreenDimensions images
 	GLFWwindow* window = nullptr;
 	bool useGraphics = true;
 	bool useCompute = false;
+	uint32_t framesInFlight = 2;
+	// Where the pipeline cache file is read from at creation and written to at destruction
+	std::string pipelineCacheDirectory = ".";
+	Dimensions2Du offscreenDimensions = { 1280,720 };
+};
+
+struct MemoryStats
+{
+	uint32_t blockCount = 0;		// device memory objects allocated from the driver
+	uint32_t allocationCount = 0;	// resources placed inside those blocks
+	uint64_t reservedBytes = 0;
+	uint64_t usedBytes = 0;
 };
 
 class RenderDevice
@@ -22,4 +37,8 @@ public:
 	virtual const Swapchain* GetSwapchain() const = 0;
 
 	virtual Buffer* CreateBuffer(const BufferDesc& desc) const = 0;
+	virtual Image* CreateImage(const ImageDesc& desc) const = 0;
+	virtual ImageView* CreateImageView(const ImageViewDesc& desc) const = 0;
+
+	virtual MemoryStats GetMemoryStats() const = 0;
 };
\ No newline at end of file
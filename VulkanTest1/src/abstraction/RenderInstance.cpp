@@ -2,7 +2,7 @@
 #include "RenderInstance.h"
 #include "VulkanImpl/VulkanRenderInstance.h"
 
-RenderInstance* RenderInstance::Create(bool debugEnabled)
+RenderInstance* RenderInstance::Create(bool debugEnabled, bool headless)
 {
-	return new VulkanRenderInstance(debugEnabled);
+	return new VulkanRenderInstance(debugEnabled, headless);
 }
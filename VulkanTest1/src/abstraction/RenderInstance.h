@@ -8,7 +8,8 @@ struct GLFWwindow;
 class RenderInstance
 {
 public:
-	static RenderInstance* Create(bool debugEnabled);
+	// A headless instance doesn't load the window system extensions, only windowless devices can be created from it
+	static RenderInstance* Create(bool debugEnabled, bool headless = false);
 public:
 	virtual ~RenderInstance() = default;
 
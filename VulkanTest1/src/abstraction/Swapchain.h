@@ -33,10 +33,17 @@ class Swapchain
 public:
 	virtual ~Swapchain() = default;
 
-	virtual SwapchainImage GetNextImage() = 0;
+	// When a receipe is given it is signaled once the image is ready and the call does not block,
+	// otherwise the call waits for the image on the cpu.
+	virtual SwapchainImage GetNextImage(Receipe* receipe = nullptr) = 0;
 	virtual void Present(ArrayProxy<Receipe*> receipes) = 0;
 	virtual void ReSize(Dimensions2Du dimensions) = 0;
 
+	// Set when acquiring or presenting reported the swapchain as out of date or suboptimal, cleared by ReSize
+	virtual bool IsOutOfDate() const = 0;
+	// Incremented every time the images are recreated, objects built on top of the images compare against it
+	virtual uint32_t GetGeneration() const = 0;
+
 	virtual ImageView* GetImageView(uint32_t i) = 0;
 	virtual const ImageDesc& GetImagesDesc() const = 0;
 	virtual uint32_t GetImageCount() const = 0;